@@ -0,0 +1,46 @@
+/*
+  This file is part of Gargantua, a UCI chess engine with NNUE evaluation
+  derived from Chess0, and inspired by Code Monkey King's bbc-1.4.
+
+  Copyright (C) 2025 Claudio M. Camacho
+
+  Gargantua is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Gargantua is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <string>
+#include <vector>
+
+
+
+// Default settings for the bench command
+#define BenchDefaultHash    16
+#define BenchDefaultThreads  1
+#define BenchDefaultDepth   10
+
+
+
+// Positions searched by the bench command, also used as the corpus for the
+// microbenchmarks
+extern const std::vector<std::string> BenchPositions;
+
+
+
+void bench(int hash, int threads, int depth, bool perf = false);
+
+
+
+#endif  //  BENCH_H
@@ -32,38 +32,16 @@ using namespace std;
 
 
 
-// A map to transform each square number into a Bitboard with only 1 bit set.
-// The NoSq square is at index [64] and is an empty Bitboard.
-Bitboard SqBB[65];
-
-
-
-// Leapers' attack (and move) tables [color][square]
-Bitboard PawnPushes[2][64];
-Bitboard PawnDoublePushes[2][64];
-Bitboard PawnAttacks[2][64];
-Bitboard KnightAttacks[64];
-Bitboard KingAttacks[64];
-
-
-
-// Slider masks and attack tables
-Bitboard BishopMasks[64];
-Bitboard RookMasks[64];
-Bitboard BishopAttacks[64][512];
-Bitboard RookAttacks[64][4096];
-
-
-
-// Pseudo-random number generator seed
+// Pseudo-random number generator states
 uint32_t rng32_state = 1804289383;
+uint64_t rng64_state = 1070372ULL;
 
 
 
 // genPawnPush
 //
 // Generate a Bitboard with the push of a pawn at a given square.
-Bitboard genPawnPush(int side, int square)
+static constexpr Bitboard genPawnPush(int side, int square)
 {
     // reliability checks
     assert((side == White) || (side == Black));
@@ -101,7 +79,7 @@ Bitboard genPawnPush(int side, int square)
 // genPawnDoublePush
 //
 // Generate a Bitboard with the double push of a pawn at a given square.
-Bitboard genPawnDoublePush(int side, int square)
+static constexpr Bitboard genPawnDoublePush(int side, int square)
 {
     // reliability checks
     assert((side == White) || (side == Black));
@@ -145,7 +123,7 @@ Bitboard genPawnDoublePush(int side, int square)
 // maskPawnAttacks
 //
 // Generate a Bitboard with all Pawn attacks from a given square.
-Bitboard maskPawnAttacks(int side, int square)
+static constexpr Bitboard maskPawnAttacks(int side, int square)
 {
     // reliability checks
     assert((side == White) || (side == Black));
@@ -189,7 +167,7 @@ Bitboard maskPawnAttacks(int side, int square)
 // maskKnightAttacks
 //
 // Generate a Bitboard with all Knight attacks from a given square.
-Bitboard maskKnightAttacks(int square)
+static constexpr Bitboard maskKnightAttacks(int square)
 {
     // reliability checks
     assert((square >= a8) && (square <= h1));
@@ -227,7 +205,7 @@ Bitboard maskKnightAttacks(int square)
 // maskKingAttacks
 //
 // Generate a Bitboard with all King attacks from a given square.
-Bitboard maskKingAttacks(int square)
+static constexpr Bitboard maskKingAttacks(int square)
 {
     // reliability checks
     assert((square >= a8) && (square <= h1));
@@ -265,7 +243,7 @@ Bitboard maskKingAttacks(int square)
 // maskBishopAttacks
 //
 // Generate a Bitboard with the occupancy bits of a bishop at a given square.
-Bitboard maskBishopAttacks(int square)
+static constexpr Bitboard maskBishopAttacks(int square)
 {
     // reliability checks
     assert((square >= a8) && (square <= h1));
@@ -304,7 +282,7 @@ Bitboard maskBishopAttacks(int square)
 // maskRookAttacks
 //
 // Generate a Bitboard with the occupancy bits of a rook at a given square.
-Bitboard maskRookAttacks(int square)
+static constexpr Bitboard maskRookAttacks(int square)
 {
     // reliability checks
     assert((square >= a8) && (square <= h1));
@@ -340,11 +318,47 @@ Bitboard maskRookAttacks(int square)
 
 
 
-// genBishopAttacks
+// Slider rays: the 4 Rook directions come first, then the 4 Bishop
+// directions, given as rank and file increments (rank 8 is rank 0).
+static constexpr int RayRank[8] = { 1, -1, 0,  0, 1,  1, -1, -1 };
+static constexpr int RayFile[8] = { 0,  0, 1, -1, 1, -1,  1, -1 };
+
+
+
+// genRays
 //
-// Generate a Bitboard with the Bishop attacks given a position and a set of
-// blocking pieces.
-Bitboard genBishopAttacks(int square, Bitboard block)
+// Generate the table [direction][square] with the squares of the ray that
+// goes from a square to the edge of the board in a given direction.
+static consteval std::array<std::array<Bitboard, 64>, 8> genRays()
+{
+    std::array<std::array<Bitboard, 64>, 8> rays{};
+
+    for (int dir = 0; dir < 8; dir++)
+    {
+        for (int square = 0; square < 64; square++)
+        {
+            int r = square / 8 + RayRank[dir];
+            int f = square % 8 + RayFile[dir];
+
+            for ( ; (r >= 0) && (r <= 7) && (f >= 0) && (f <= 7); r += RayRank[dir], f += RayFile[dir])
+                rays[dir][square] |= (1ULL << (r * 8 + f));
+        }
+    }
+
+
+    return rays;
+}
+
+static constexpr std::array<std::array<Bitboard, 64>, 8> Rays = genRays();
+
+
+
+// genSliderAttacks
+//
+// Generate a Bitboard with the attacks of a slider moving along the given
+// 4 directions, given a position and a set of blocking pieces: every ray is
+// cut right after its first blocker (the nearest one to the square).
+static constexpr Bitboard genSliderAttacks(int square, Bitboard block, int firstDir)
 {
     // reliability checks
     assert((square >= a8) && (square <= h1));
@@ -354,39 +368,20 @@ Bitboard genBishopAttacks(int square, Bitboard block)
     Bitboard attacks = 0ULL;
 
 
-    // rank and file, plus target ranks and files (of the diagonals)
-    int r, f;
-    int tr = square / 8;
-    int tf = square % 8;
+    for (int dir = firstDir; dir < firstDir + 4; dir++)
+    {
+        Bitboard ray = Rays[dir][square];
+        Bitboard blockers = ray & block;
 
+        // rays going to higher squares meet their nearest blocker at the
+        // lowest bit, and rays going to lower squares, at the highest bit
+        if (blockers)
+        {
+            bool up = (RayRank[dir] > 0) || ((RayRank[dir] == 0) && (RayFile[dir] > 0));
+            ray ^= Rays[dir][up ? ls1b(blockers) : (63 - __builtin_clzll(blockers))];
+        }
 
-    // generate Bishop atacks
-    for (r = tr + 1, f = tf + 1; r <= 7 && f <= 7; r++, f++)
-    {
-        attacks |= (1ULL << (r * 8 + f));
-        if ((1ULL << (r * 8 + f)) & block)
-            break;
-    }
-    
-    for (r = tr - 1, f = tf + 1; r >= 0 && f <= 7; r--, f++)
-    {
-        attacks |= (1ULL << (r * 8 + f));
-        if ((1ULL << (r * 8 + f)) & block)
-            break;
-    }
-    
-    for (r = tr + 1, f = tf - 1; r <= 7 && f >= 0; r++, f--)
-    {
-        attacks |= (1ULL << (r * 8 + f));
-        if ((1ULL << (r * 8 + f)) & block)
-            break;
-    }
-    
-    for (r = tr - 1, f = tf - 1; r >= 0 && f >= 0; r--, f--)
-    {
-        attacks |= (1ULL << (r * 8 + f));
-        if ((1ULL << (r * 8 + f)) & block)
-            break;
+        attacks |= ray;
     }
 
 
@@ -396,193 +391,180 @@ Bitboard genBishopAttacks(int square, Bitboard block)
 
 
 
+// genBishopAttacks
+//
+// Generate a Bitboard with the Bishop attacks given a position and a set of
+// blocking pieces.
+static constexpr Bitboard genBishopAttacks(int square, Bitboard block)
+{
+    return genSliderAttacks(square, block, 4);
+}
+
+
+
 // genRookAttacks
 //
 // Generate a Bitboard with the Rook attacks given a position and a set of
 // blocking pieces.
-Bitboard genRookAttacks(int square, Bitboard block)
+static constexpr Bitboard genRookAttacks(int square, Bitboard block)
 {
-    // reliability checks
-    assert((square >= a8) && (square <= h1));
+    return genSliderAttacks(square, block, 0);
+}
 
 
-    // result attacks bitboard
-    Bitboard attacks = 0ULL;
-  
 
-    // rank and file, plus target ranks and files (of the diagonals)
-    int r, f;
-    int tr = square / 8;
-    int tf = square % 8;
-  
+// genSquareBitmaps
+//
+// Generate the table with a Bitboard with only 1 bit set for every square.
+static consteval std::array<Bitboard, 65> genSquareBitmaps()
+{
+    // the NoSq entry stays empty
+    std::array<Bitboard, 65> bitmaps{};
 
-    // generate rook attacks
-    for (r = tr + 1; r <= 7; r++)
-    {
-        attacks |= (1ULL << (r * 8 + tf));
-        if ((1ULL << (r * 8 + tf)) & block)
-            break;
-    }
-    
-    for (r = tr - 1; r >= 0; r--)
-    {
-        attacks |= (1ULL << (r * 8 + tf));
-        if ((1ULL << (r * 8 + tf)) & block)
-            break;
-    }
-    
-    for (f = tf + 1; f <= 7; f++)
-    {
-        attacks |= (1ULL << (tr * 8 + f));
-        if ((1ULL << (tr * 8 + f)) & block)
-            break;
-    }
-    
-    for (f = tf - 1; f >= 0; f--)
-    {
-        attacks |= (1ULL << (tr * 8 + f));
-        if ((1ULL << (tr * 8 + f)) & block)
-            break;
-    }
-  
+    for (int square = 0; square < 64; square++)
+        setBit(bitmaps[square], square);
 
-    // return attack map
-    return attacks;
+
+    return bitmaps;
 }
 
 
 
-// setOccupancy
+// genPawnTable
 //
-// Set the occupancy bits based on the pieces on the board.
-Bitboard setOccupancy(int index, int bitMask, Bitboard attackMask)
+// Generate a table [color][square] with the given pawn moves or attacks.
+static consteval std::array<std::array<Bitboard, 64>, 2> genPawnTable(Bitboard (*gen)(int, int))
 {
-    // occupancy map
-    Bitboard occupancy = 0ULL;
+    std::array<std::array<Bitboard, 64>, 2> table{};
 
-    
-    // loop over the range of bits within attack mask
-    for (int count = 0; count < bitMask; count++)
+    for (int square = 0; square < 64; square++)
     {
-        // get LS1B index of attacks mask
-        int square = ls1b(attackMask);
-
-        // pop LS1B in attack map
-        attackMask ^= SqBB[square];
-        
-        // make sure occupancy is on board and populate occupancy map
-        if (index & (1 << count))
-            occupancy |= (1ULL << square);
+        table[White][square] = gen(White, square);
+        table[Black][square] = gen(Black, square);
     }
-   
 
-    // return occupancy map
-    return occupancy;
+
+    return table;
 }
 
 
 
-// initBitmaps
+// genLeaperTable
 //
-// Initialize different bitmap tables for faster lookup.
-void initBitmaps()
+// Generate a table [square] with the given Knight or King attacks.
+static consteval std::array<Bitboard, 64> genLeaperTable(Bitboard (*gen)(int))
 {
-    // populate SqBB
-    memset(SqBB, 0ULL, sizeof(SqBB));
+    std::array<Bitboard, 64> table{};
+
     for (int square = 0; square < 64; square++)
-        setBit(SqBB[square], square);
+        table[square] = gen(square);
+
+
+    return table;
 }
 
 
 
-// initLeaperAttacks
+// genSliderMagics
 //
-// Initialize the leaper pieces' attacks.
-void initLeaperAttacks()
+// Generate the relevant occupancy masks, magic numbers and shifts of the
+// given slider for every square, and the offsets of their attacks within the
+// shared table. The Bishop attacks go first, followed by the Rook attacks.
+static consteval std::array<SliderMagic_t, 64> genSliderMagics(Slider isBishop)
 {
+    std::array<SliderMagic_t, 64> magics{};
+    uint32_t offset = isBishop ? 0 : BishopTableSize;
+
+
     // loop over the 64 board squares
     for (int square = 0; square < 64; square++)
     {
-        // init Pawn pushes and attacks
-        PawnPushes[White][square] = genPawnPush(White, square);
-        PawnPushes[Black][square] = genPawnPush(Black, square);
-        PawnDoublePushes[White][square] = genPawnDoublePush(White, square);
-        PawnDoublePushes[Black][square] = genPawnDoublePush(Black, square);
-        PawnAttacks[White][square] = maskPawnAttacks(White, square);
-        PawnAttacks[Black][square] = maskPawnAttacks(Black, square);
+        int RelevantBitsCount = isBishop ? BishopRelevantBits[square] : RookRelevantBits[square];
 
+        magics[square].mask   = isBishop ? maskBishopAttacks(square) : maskRookAttacks(square);
+        magics[square].magic  = isBishop ? BishopMagicNumbers[square] : RookMagicNumbers[square];
+        magics[square].shift  = 64 - RelevantBitsCount;
+        magics[square].offset = offset;
 
-        // init Knight attacks
-        KnightAttacks[square] = maskKnightAttacks(square);
+        offset += 1 << RelevantBitsCount;
+    }
 
 
-        // init King attacks
-        KingAttacks[square] = maskKingAttacks(square);
-    }
+    return magics;
 }
 
 
 
-// initSliderAttacks
+// Slider magics
+constexpr std::array<SliderMagic_t, 64> BishopMagics = genSliderMagics(Bishop);
+constexpr std::array<SliderMagic_t, 64> RookMagics   = genSliderMagics(Rook);
+
+static_assert(RookMagics[0].offset == BishopTableSize);
+static_assert(RookMagics[63].offset + (1 << RookRelevantBits[63]) == SliderTableSize);
+
+
+
+// genSliderTable
 //
-// Initialize the slider pieces' attacks.
-void initSliderAttacks(Slider isBishop)
+// Generate the shared attack table of both sliders, for every square and
+// every variation of its relevant occupancy bits.
+static consteval std::array<Bitboard, SliderTableSize> genSliderTable()
 {
-    // loop over the 64 board squares
+    std::array<Bitboard, SliderTableSize> attacks{};
+
+
     for (int square = 0; square < 64; square++)
     {
-        // init Bishop & Rook masks
-        BishopMasks[square] = maskBishopAttacks(square);
-        RookMasks[square] = maskRookAttacks(square);
-
-        
-        // init current mask
-        Bitboard AttackMask = isBishop ? BishopMasks[square] : RookMasks[square];
+        for (Slider isBishop : { Bishop, Rook })
+        {
+            const SliderMagic_t &magic = isBishop ? BishopMagics[square] : RookMagics[square];
+            int RelevantBitsCount = 64 - magic.shift;
 
-        
-        // init relevant occupancy bit count
-        int RelevantBitsCount = countBits(AttackMask);
 
-        
-        // init occupancy indices
-        int OccupancyIndices = (1 << RelevantBitsCount);
+            // loop over the occupancy variations, i.e., all the subsets of
+            // the mask, enumerated with the Carry-Rippler trick: the n-th
+            // subset has the bits of n deposited into the mask
+            //
+            // @see https://www.chessprogramming.org/Traversing_Subsets_of_a_Set
+            Bitboard occupancy = 0ULL;
 
-        
-        // loop over occupancy indices
-        for (int index = 0; index < OccupancyIndices; index++)
-        {
-            // Bishop
-            if (isBishop)
+            for (unsigned index = 0; index < (1U << RelevantBitsCount); index++)
             {
-                // init current occupancy variation
-                Bitboard occupancy = setOccupancy(index, RelevantBitsCount, AttackMask);
-                
-                // init magic index
-                int MagicIndex = (occupancy * BishopMagicNumbers[square]) >> (64 - BishopRelevantBits[square]);
-                
-                // init bishop attacks
-                BishopAttacks[square][MagicIndex] = genBishopAttacks(square, occupancy);
-            }
-
-            
-            // Rook
-            else
-            {
-                // init current occupancy variation
-                Bitboard occupancy = setOccupancy(index, RelevantBitsCount, AttackMask);
-                
-                // init magic index
-                int MagicIndex = (occupancy * RookMagicNumbers[square]) >> (64 - RookRelevantBits[square]);
-                
-                // init rook attacks
-                RookAttacks[square][MagicIndex] = genRookAttacks(square, occupancy);
+                // PEXT extracts the occupancy bits back into n, so the
+                // variation index is n itself; otherwise, use the magic number
+#ifdef USE_BMI2
+                unsigned slot = index;
+#else
+                unsigned slot = (occupancy * magic.magic) >> magic.shift;
+#endif
+
+                attacks[magic.offset + slot] = isBishop ? genBishopAttacks(square, occupancy)
+                                                        : genRookAttacks(square, occupancy);
+
+                occupancy = (occupancy - magic.mask) & magic.mask;
             }
         }
     }
+
+
+    return attacks;
 }
 
 
 
+// Lookup tables (@see bitboard.h)
+constexpr std::array<Bitboard, 65> SqBB = genSquareBitmaps();
+
+constexpr std::array<std::array<Bitboard, 64>, 2> PawnPushes       = genPawnTable(genPawnPush);
+constexpr std::array<std::array<Bitboard, 64>, 2> PawnDoublePushes = genPawnTable(genPawnDoublePush);
+constexpr std::array<std::array<Bitboard, 64>, 2> PawnAttacks      = genPawnTable(maskPawnAttacks);
+constexpr std::array<Bitboard, 64> KnightAttacks = genLeaperTable(maskKnightAttacks);
+constexpr std::array<Bitboard, 64> KingAttacks   = genLeaperTable(maskKingAttacks);
+
+constexpr std::array<Bitboard, SliderTableSize> SliderAttacks = genSliderTable();
+
+
+
 // printBitboard
 //
 // Take a Bitboard and display it as a board representation on the standard
@@ -622,16 +604,3 @@ void printBitboard(Bitboard bb)
     cout << endl << "Bitboard: " << bb << "ULL" << endl << endl;
 }
 
-
-
-// initBitboards
-//
-// Call all different functions that initialize fundamental data structures
-// and Bitboards to make the engine work.
-void initBitboards()
-{
-    initBitmaps();
-    initLeaperAttacks();
-    initSliderAttacks(Bishop);
-    initSliderAttacks(Rook);
-}
@@ -26,6 +26,10 @@
 #include <cassert>
 #include <cstdint>
 
+#ifdef USE_BMI2
+#include <immintrin.h>
+#endif
+
 
 
 // Bitboard data type = unsigned long long (64-bit number)
@@ -33,6 +37,11 @@
 
 
 
+// Move data type = unsigned short (16-bit number, @see movgen.h)
+#define Move uint16_t
+
+
+
 // Colors (and side to move)
 enum Side { White, Black, Both, NoColor };
 
@@ -120,31 +129,61 @@ static constexpr Bitboard DCB8_Mask = 14ULL;
 
 
 
+// Lookup tables:
+//
+// All the tables below are generated at compile time (@see bitboard.cpp), so
+// they are stored in the read-only data of the binary, need no initialization
+// at startup and are shared by all running engine processes.
+
+
+
 // A map to transform each square number into a Bitboard with only 1 bit set.
 // The NoSq square is at index [64] and is an empty Bitboard.
-extern Bitboard SqBB[65];
+extern const std::array<Bitboard, 65> SqBB;
 
 
 
 // Leapers' attack tables [color][square]
-extern Bitboard PawnPushes[2][64];
-extern Bitboard PawnDoublePushes[2][64];
-extern Bitboard PawnAttacks[2][64];
-extern Bitboard KnightAttacks[64];
-extern Bitboard KingAttacks[64];
+extern const std::array<std::array<Bitboard, 64>, 2> PawnPushes;
+extern const std::array<std::array<Bitboard, 64>, 2> PawnDoublePushes;
+extern const std::array<std::array<Bitboard, 64>, 2> PawnAttacks;
+extern const std::array<Bitboard, 64> KnightAttacks;
+extern const std::array<Bitboard, 64> KingAttacks;
+
 
 
+// Slider attack tables:
+//
+// The attacks of all the Bishop and Rook occupancy variations are stored in
+// a single compact table ("fancy" magic bitboards): every square only takes
+// as many entries as variations of its relevant occupancy bits, i.e., 2^N
+// where N is BishopRelevantBits or RookRelevantBits. SliderMagic_t holds,
+// for each square, the relevant occupancy mask, the magic number and shift
+// and the offset of the square's attacks within the table.
+//
+// With BMI2, the index of the occupancy variation is extracted directly
+// with the PEXT instruction, and the magic numbers are not needed.
+#define BishopTableSize    5248
+#define RookTableSize    102400
+#define SliderTableSize  (BishopTableSize + RookTableSize)
 
-// Slider masks and attack tables
-extern Bitboard BishopMasks[64];
-extern Bitboard RookMasks[64];
-extern Bitboard BishopAttacks[64][512];
-extern Bitboard RookAttacks[64][4096];
+typedef struct
+{
+    Bitboard mask;
+    Bitboard magic;
+    uint32_t offset;
+    int      shift;
+} SliderMagic_t;
 
+extern const std::array<SliderMagic_t, 64> BishopMagics;
+extern const std::array<SliderMagic_t, 64> RookMagics;
+extern const std::array<Bitboard, SliderTableSize> SliderAttacks;
 
 
-// Pseudo-random number generator seed
+
+// Pseudo-random number generator seeds
 extern uint32_t rng32_state;
+extern uint64_t rng64_state;
 
 
 
@@ -322,18 +361,8 @@ static constexpr Bitboard BishopMagicNumbers[64] =
 
 
 
-// Functions for initializing, printing and manipulating Bitboard data
-// structures and information:
+// Functions for printing Bitboard data structures and information:
 void printBitboard(Bitboard);
-Bitboard genPawnPush(int, int);
-Bitboard genPawnDoublePush(int, int);
-Bitboard maskBishopAttacks(int);
-Bitboard maskRookAttacks(int);
-Bitboard setOccupancy(int, int, Bitboard);
-void initBitmaps();
-void initLeaperAttacks();
-void initSliderAttacks(Slider);
-void initBitboards();
 
 
 
@@ -525,19 +554,28 @@ constexpr int popLsb(Bitboard& b)
 
 
 
+// sliderIndex
+//
+// Index of the given occupancy variation within the attacks of a square.
+static inline unsigned sliderIndex(const SliderMagic_t &magic, Bitboard occupancy)
+{
+#ifdef USE_BMI2
+    return _pext_u64(occupancy, magic.mask);
+#else
+    return ((occupancy & magic.mask) * magic.magic) >> magic.shift;
+#endif
+}
+
+
+
 // getBishopAttacks
 //
 // Generate a Bitboard with the pseudo-legal Bishop attacks.
 static inline Bitboard getBishopAttacks(int square, Bitboard occupancy)
 {
-    // get bishop attacks assuming current board occupancy
-    occupancy &= BishopMasks[square];
-    occupancy *= BishopMagicNumbers[square];
-    occupancy >>= 64 - BishopRelevantBits[square];
-   
+    const SliderMagic_t &magic = BishopMagics[square];
 
-    // return bishop attacks
-    return BishopAttacks[square][occupancy];
+    return SliderAttacks[magic.offset + sliderIndex(magic, occupancy)];
 }
 
 
@@ -547,14 +585,9 @@ static inline Bitboard getBishopAttacks(int square, Bitboard occupancy)
 // Generate a Bitboard with the pseudo-legal Rook attacks.
 static inline Bitboard getRookAttacks(int square, Bitboard occupancy)
 {
-    // get rook attacks assuming current board occupancy
-    occupancy &= RookMasks[square];
-    occupancy *= RookMagicNumbers[square];
-    occupancy >>= 64 - RookRelevantBits[square];
-   
+    const SliderMagic_t &magic = RookMagics[square];
 
-    // return rook attacks
-    return RookAttacks[square][occupancy];
+    return SliderAttacks[magic.offset + sliderIndex(magic, occupancy)];
 }
 
 
@@ -564,31 +597,28 @@ static inline Bitboard getRookAttacks(int square, Bitboard occupancy)
 // Generate a Bitboard with the pseudo-legal Queen attacks.
 static inline Bitboard getQueenAttacks(int square, Bitboard occupancy)
 {
-    // init Queen attacks Bitboard
-    Bitboard QueenAttacks = 0ULL;
-   
+    return getBishopAttacks(square, occupancy) | getRookAttacks(square, occupancy);
+}
 
-    // init Bishop and Rook occupancies
-    Bitboard BishopOccupancy = occupancy;
-    Bitboard RookOccupancy = occupancy;
-
-    
-    // get Bishop and Rook attacks assuming current board occupancy
-    BishopOccupancy &= BishopMasks[square];
-    BishopOccupancy *= BishopMagicNumbers[square];
-    BishopOccupancy >>= 64 - BishopRelevantBits[square];
-
-    QueenAttacks = BishopAttacks[square][BishopOccupancy];
-    
-    RookOccupancy &= RookMasks[square];
-    RookOccupancy *= RookMagicNumbers[square];
-    RookOccupancy >>= 64 - RookRelevantBits[square];
-    
-    QueenAttacks |= RookAttacks[square][RookOccupancy];
-
-    
-    // return Queen attacks
-    return QueenAttacks;
+
+
+// getSquaresBetween
+//
+// Generate a Bitboard with the squares strictly between the two given
+// squares, if they are on the same rank, file or diagonal (empty otherwise).
+static inline Bitboard getSquaresBetween(int square1, int square2)
+{
+    // same diagonal: intersect the Bishop rays blocked by each other
+    if (getBishopAttacks(square1, 0ULL) & SqBB[square2])
+        return getBishopAttacks(square1, SqBB[square2]) & getBishopAttacks(square2, SqBB[square1]);
+
+
+    // same rank or file: intersect the Rook rays blocked by each other
+    if (getRookAttacks(square1, 0ULL) & SqBB[square2])
+        return getRookAttacks(square1, SqBB[square2]) & getRookAttacks(square2, SqBB[square1]);
+
+
+    return 0ULL;
 }
 
 
@@ -626,22 +656,33 @@ static inline uint32_t rng32()
 
 // rng64
 //
-// Generate a 64-bit pseudo-random number.
-static inline uint64_t rng64()
+// Generate a 64-bit pseudo-random number, using XORSHIFT on a 64-bit state
+// followed by a multiplication (xorshift64*). Plain XORSHIFT is linear, so
+// 64-bit numbers made out of rng32() would all lie in a 32-bit space, and
+// any hash keys built from them would collide as if they were 32-bit.
+//
+// This version takes the state explicitly, so that it can also be used at
+// compile time (e.g., to generate the Zobrist keys).
+constexpr uint64_t rng64(uint64_t &state)
 {
-    // define 4 random numbers
-    uint64_t n1, n2, n3, n4;
-   
+    // XOR shift algorithm
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
 
-    // init random numbers slicing 16 bits from MS1B side
-    n1 = (uint64_t)(rng32() & 0xFFFF);
-    n2 = (uint64_t)(rng32() & 0xFFFF);
-    n3 = (uint64_t)(rng32() & 0xFFFF);
-    n4 = (uint64_t)(rng32() & 0xFFFF);
-   
 
-    // return random number
-    return (uint64_t) (n1 | (n2 << 16) | (n3 << 32) | (n4 << 48));
+    // return scrambled random number
+    return state * 2685821657736338717ULL;
+}
+
+
+
+// rng64
+//
+// Generate a 64-bit pseudo-random number from the global state.
+static inline uint64_t rng64()
+{
+    return rng64(rng64_state);
 }
 
 
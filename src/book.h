@@ -0,0 +1,47 @@
+/*
+  This file is part of Gargantua, a UCI chess engine with NNUE evaluation
+  derived from Chess0, and inspired by Code Monkey King's bbc-1.4.
+
+  Copyright (C) 2025 Claudio M. Camacho
+
+  Gargantua is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Gargantua is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BOOK_H
+#define BOOK_H
+
+#include <string>
+#include <cstdint>
+
+#include "bitboard.h"
+
+
+
+// Opening book, either in Polyglot (.bin) format or in Gargantua's own
+// format (built with Book::build()). The book file is memory-mapped and
+// looked up with a binary search, so that moves in the opening are played
+// instantly, without any search.
+namespace Book
+{
+
+bool init(const std::string &);
+uint64_t polyglotKey();
+Move probe();
+bool build(const std::string &, const std::string &);
+
+}  //  namespace Book
+
+
+
+#endif  //  BOOK_H
@@ -26,7 +26,9 @@
 #include "search.h"
 #include "uci.h"
 #include "tt.h"
+#include "tb.h"
 #include "tbprobe.h"
+#include "trace.h"
 
 
 
@@ -44,8 +46,7 @@ int main(int argc, char *argv[])
 
 
     // initializations
-    initBitboards();
-    initRandomKeys();
+    initCuckoo();
     initSearch();
 
 
@@ -53,10 +54,10 @@ int main(int argc, char *argv[])
     TT::init(1024);
 
 
-    // initialize tablebases (syzygy)
-    // if (options["SyzygyPath"] != "")
-    //     tb_init(options["SyzygyPath"])   
-    // SyzygyPath = syzygy -- by default
+    // initialize tablebases' caches (syzygy); the tables themselves are
+    // loaded when the GUI sets the SyzygyPath option
+    TB::initCache(SyzygyCacheDefault);
+    tb_set_block_cache_size(SyzygyBlockCacheDefault);
 
 
     // initialize neural network (NNUE) for evaluation
@@ -68,6 +69,14 @@ int main(int argc, char *argv[])
     UCI::loop(argc, argv);
 
 
+    // release the tablebases (stopping any preloading in progress)
+    tb_free();
+
+
+    // finish the trace file, if any
+    Trace::close();
+
+
     // terminate program
     return 0;
 }
@@ -0,0 +1,93 @@
+/*
+  This file is part of Gargantua, a UCI chess engine with NNUE evaluation
+  derived from Chess0, and inspired by Code Monkey King's bbc-1.4.
+
+  Copyright (C) 2025 Claudio M. Camacho
+
+  Gargantua is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Gargantua is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "bitboard.h"
+#include "position.h"
+#include "material.h"
+
+
+
+// Material table (per thread)
+thread_local MaterialEntry_t materialTable[MaterialTableSize];
+
+
+
+// computeMaterial
+//
+// Fill in the material table entry for the material of the current position
+// (whose material key is given), from the piece counts.
+void computeMaterial(MaterialEntry_t *entry, uint64_t key)
+{
+    // count the pieces on the board
+    int total = 0;
+
+    for (int piece = P; piece <= k; piece++)
+        total += pieceCount[piece];
+
+    int pawns   = pieceCount[P] + pieceCount[p];
+    int knights = pieceCount[N] + pieceCount[n];
+    int bishops = pieceCount[B] + pieceCount[b];
+    int rooks   = pieceCount[R] + pieceCount[r];
+    int queens  = pieceCount[Q] + pieceCount[q];
+
+    int white_minors = pieceCount[N] + pieceCount[B];
+    int black_minors = pieceCount[n] + pieceCount[b];
+
+
+    // insufficient material (see isDraw()):
+    //
+    // K-K, Kminor-K, KNN-K and Kminor-Kminor endings
+    entry->draw = MaterialNoDraw;
+
+    if ((total == 2)
+        || ((total == 3) && (white_minors || black_minors))
+        || ((total == 4) && ((pieceCount[N] == 2) || (pieceCount[n] == 2)
+                             || (white_minors && black_minors))))
+    {
+        entry->draw = MaterialDraw;
+    }
+
+
+    // only kings and bishops left
+    else if (bishops && !(pawns || knights || rooks || queens))
+        entry->draw = MaterialDraw;
+
+
+    // Kminorminor-Kminor ending: a draw, unless either side has 2 bishops;
+    // White's 2 bishops only win if they are on different colors
+    else if ((total == 5) && ((white_minors + black_minors) == 3))
+    {
+        if (pieceCount[b] == 2)
+            entry->draw = MaterialNoDraw;
+        else if (pieceCount[B] == 2)
+            entry->draw = MaterialDrawUnlessBishopPair;
+        else
+            entry->draw = MaterialDraw;
+    }
+
+
+    // game phase and endgame detection
+    int phase = knights + bishops + 2 * rooks + 4 * queens;
+
+    entry->phase    = (phase < MaterialMaxPhase) ? phase : MaterialMaxPhase;
+    entry->endgame  = (pawns * 100 + knights * 320 + bishops * 320 + rooks * 500 + queens * 950) < 2600;
+    entry->noPieces = (total - pawns - 2) == 0;
+    entry->key      = key;
+}
@@ -0,0 +1,89 @@
+/*
+  This file is part of Gargantua, a UCI chess engine with NNUE evaluation
+  derived from Chess0, and inspired by Code Monkey King's bbc-1.4.
+
+  Copyright (C) 2025 Claudio M. Camacho
+
+  Gargantua is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Gargantua is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+#include <cstdint>
+
+
+
+// Results of the insufficient material check of a material table entry
+enum MaterialDrawType
+{
+    MaterialNoDraw,
+    MaterialDraw,
+    MaterialDrawUnlessBishopPair  // draw, unless White's 2 bishops are on different colors
+};
+
+
+
+// Game phase of a material table entry, from 0 (only kings and pawns) to
+// MaterialMaxPhase (all pieces on the board)
+#define MaterialMaxPhase   24
+
+
+
+// Size of the material table (no. of entries, power of 2)
+#define MaterialTableSize  4096
+
+
+
+// MaterialEntry_t is the material table entry: everything the search needs
+// to know that only depends on the material (number of pieces of every type)
+// on the board, computed once per material configuration.
+typedef struct
+{
+    uint64_t key;
+    uint8_t  draw;
+    uint8_t  phase;
+    bool     endgame;
+    bool     noPieces;
+} MaterialEntry_t;
+
+
+
+// Material table, indexed by the material key. Every thread has its own, so
+// that it can be filled in without any synchronization.
+extern thread_local MaterialEntry_t materialTable[MaterialTableSize];
+
+
+
+void computeMaterial(MaterialEntry_t *, uint64_t);
+
+
+
+// probeMaterial
+//
+// Return the material table entry for the given material key, computing it
+// for the current position if it is not in the table yet.
+static inline const MaterialEntry_t *probeMaterial(uint64_t key)
+{
+    MaterialEntry_t *entry = &materialTable[key & (MaterialTableSize - 1)];
+
+    if (entry->key != key)
+        computeMaterial(entry, key);
+
+    return entry;
+}
+
+
+
+#endif  //  MATERIAL_H
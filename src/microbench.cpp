@@ -0,0 +1,361 @@
+/*
+  This file is part of Gargantua, a UCI chess engine with NNUE evaluation
+  derived from Chess0, and inspired by Code Monkey King's bbc-1.4.
+
+  Copyright (C) 2025 Claudio M. Camacho
+
+  Gargantua is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Gargantua is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#include "nnue.h"
+#include "bitboard.h"
+#include "position.h"
+#include "movgen.h"
+#include "search.h"
+#include "eval.h"
+#include "tt.h"
+#include "bench.h"
+
+
+
+using namespace std;
+
+
+
+// Microbenchmarks of the engine's core kernels (move generation, make/undo,
+// attacks, SEE, hash table, evaluation), built as a separate executable with
+// "make microbench".
+//
+// Every kernel is run over the positions of the bench suite, a number of
+// warmup runs first and then a number of timed repetitions. Each repetition
+// reports the average time per operation (ns/op); the results show the mean,
+// the standard deviation and the best of all repetitions.
+#define MicrobenchWarmup        2
+#define MicrobenchRepetitions  10
+#define MicrobenchInnerLoops   32
+#define MicrobenchTTKeys     (1 << 16)
+
+
+
+// Snapshot of a position of the corpus, and its moves
+typedef struct
+{
+    Bitboard bitboards[12];
+    Bitboard occupancies[3];
+    int sideToMove;
+    int epsq;
+    int castle;
+    int fifty;
+    uint64_t hash_key;
+    MoveList_t moves;
+    MoveList_t captures;
+} Snapshot_t;
+
+
+
+static vector<Snapshot_t> corpus;
+static vector<uint64_t>   tt_keys;
+
+
+// results of the kernels are accumulated here, so that the compiler can't
+// optimize the kernels away
+static volatile uint64_t sink = 0ULL;
+
+static inline void keep(uint64_t result)
+{
+    sink = sink + result;
+}
+
+
+
+// loadSnapshot
+//
+// Set up the given position of the corpus on the board.
+static inline void loadSnapshot(const Snapshot_t &s)
+{
+    memcpy(bitboards, s.bitboards, sizeof(bitboards));
+    memcpy(occupancies, s.occupancies, sizeof(occupancies));
+
+    sideToMove = s.sideToMove;
+    epsq       = s.epsq;
+    castle     = s.castle;
+    fifty      = s.fifty;
+    hash_key   = s.hash_key;
+}
+
+
+
+// initCorpus
+//
+// Take a snapshot of every position of the bench suite, with its moves.
+static void initCorpus()
+{
+    for (const string &fen : BenchPositions)
+    {
+        Snapshot_t s;
+
+        setPosition(fen);
+
+        memcpy(s.bitboards, bitboards, sizeof(bitboards));
+        memcpy(s.occupancies, occupancies, sizeof(occupancies));
+
+        s.sideToMove = sideToMove;
+        s.epsq       = epsq;
+        s.castle     = castle;
+        s.fifty      = fifty;
+        s.hash_key   = hash_key;
+
+        generateMoves(s.moves);
+        generateCapturesAndPromotions(s.captures);
+
+        corpus.push_back(s);
+    }
+
+
+    // random keys to fill in and look up the hash table
+    for (int i = 0; i < MicrobenchTTKeys; i++)
+        tt_keys.push_back(rng64());
+}
+
+
+
+// run
+//
+// Time the given kernel over the whole corpus and print the results. The
+// kernel is called on every position of the corpus, and it returns the number
+// of operations it performed. Setting up the positions is not timed.
+template <typename Kernel>
+static void run(const string &name, Kernel kernel)
+{
+    vector<double> samples;
+    uint64_t ops = 0;
+
+
+    for (int rep = -MicrobenchWarmup; rep < MicrobenchRepetitions; rep++)
+    {
+        uint64_t ns = 0, count = 0;
+
+        for (const Snapshot_t &s : corpus)
+        {
+            loadSnapshot(s);
+
+            auto start = chrono::steady_clock::now();
+
+            for (int i = 0; i < MicrobenchInnerLoops; i++)
+                count += kernel(s);
+
+            ns += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+        }
+
+        // warmup runs are not taken into account
+        if ((rep >= 0) && count)
+        {
+            samples.push_back(double(ns) / count);
+            ops = count;
+        }
+    }
+
+
+    // mean, standard deviation and best of the repetitions
+    double mean = 0.0, var = 0.0, best = samples[0];
+
+    for (double x : samples)
+    {
+        mean += x / samples.size();
+        best  = min(best, x);
+    }
+
+    for (double x : samples)
+        var += (x - mean) * (x - mean) / samples.size();
+
+
+    cout << left  << setw(34) << name << right << fixed << setprecision(2)
+         << setw(10) << mean
+         << setw(10) << sqrt(var)
+         << setw(8)  << setprecision(1) << (mean > 0 ? 100.0 * sqrt(var) / mean : 0.0) << "%"
+         << setw(10) << setprecision(2) << best
+         << setw(12) << ops << endl << flush;
+}
+
+
+
+int main()
+{
+    // initializations
+    initCuckoo();
+    initSearch();
+    TT::init(16);
+    nnue_init("nn-eba324f53044.nnue");
+    initCorpus();
+
+
+    cout << endl << corpus.size() << " positions, " << MicrobenchWarmup
+         << " warmup runs, " << MicrobenchRepetitions << " repetitions" << endl << endl;
+
+    cout << left  << setw(34) << "kernel" << right
+         << setw(10) << "ns/op" << setw(10) << "stddev" << setw(9) << "(%)"
+         << setw(10) << "best" << setw(12) << "ops" << endl;
+
+
+    // move generation
+    run("generateMoves", [](const Snapshot_t &)
+    {
+        MoveList_t MoveList;
+        generateMoves(MoveList);
+        keep(MoveList.count);
+        return 1;
+    });
+
+    run("generateCapturesAndPromotions", [](const Snapshot_t &)
+    {
+        MoveList_t MoveList;
+        generateCapturesAndPromotions(MoveList);
+        keep(MoveList.count);
+        return 1;
+    });
+
+
+    // make and undo every pseudo-legal move
+    run("makeMove+takeBack", [](const Snapshot_t &s)
+    {
+        for (int i = 0; i < s.moves.count; i++)
+        {
+            saveBoard();
+            keep(makeMove(s.moves.moves[i].move));
+            takeBack();
+        }
+        return s.moves.count;
+    });
+
+
+    // attacks to every square, by both sides
+    run("isSquareAttacked", [](const Snapshot_t &)
+    {
+        int attacked = 0;
+
+        for (int sq = 0; sq < 64; sq++)
+            attacked += isSquareAttacked(sq, White) + isSquareAttacked(sq, Black);
+
+        keep(attacked);
+        return 128;
+    });
+
+
+    // slider attacks from every square, with the occupancy of the position
+    run("getRookAttacks", [](const Snapshot_t &)
+    {
+        Bitboard attacks = 0ULL;
+
+        for (int sq = 0; sq < 64; sq++)
+            attacks ^= getRookAttacks(sq, occupancies[Both]);
+
+        keep(attacks);
+        return 64;
+    });
+
+    run("getBishopAttacks", [](const Snapshot_t &)
+    {
+        Bitboard attacks = 0ULL;
+
+        for (int sq = 0; sq < 64; sq++)
+            attacks ^= getBishopAttacks(sq, occupancies[Both]);
+
+        keep(attacks);
+        return 64;
+    });
+
+
+    // static exchange evaluation of every capture: full value and threshold
+    run("see", [](const Snapshot_t &s)
+    {
+        int score = 0, count = 0;
+
+        for (int i = 0; i < s.captures.count; i++)
+            if (getMoveCapture(s.captures.moves[i].move))
+            {
+                score += see(s.captures.moves[i].move);
+                count++;
+            }
+
+        keep(score);
+        return count;
+    });
+
+    run("seeGE", [](const Snapshot_t &s)
+    {
+        int passed = 0, count = 0;
+
+        for (int i = 0; i < s.captures.count; i++)
+            if (getMoveCapture(s.captures.moves[i].move))
+            {
+                passed += seeGE(s.captures.moves[i].move, 0);
+                count++;
+            }
+
+        keep(passed);
+        return count;
+    });
+
+
+    // hash table: store and look up random positions (mostly cache misses)
+    run("TT::save", [](const Snapshot_t &)
+    {
+        static int next = 0;
+
+        for (int i = 0; i < 64; i++)
+        {
+            hash_key = tt_keys[next++ & (MicrobenchTTKeys - 1)];
+            TT::save(i, i, 1 + (i & 7), hash_type_exact);
+        }
+        return 64;
+    });
+
+    run("TT::probe", [](const Snapshot_t &)
+    {
+        static int next = 0;
+        Move move;
+        int score = 0;
+
+        for (int i = 0; i < 64; i++)
+        {
+            hash_key = tt_keys[next++ & (MicrobenchTTKeys - 1)];
+            score += TT::probe(-ValueInfinite, ValueInfinite, move, 1);
+        }
+
+        keep(score);
+        return 64;
+    });
+
+
+    // evaluation
+    run("evaluate", [](const Snapshot_t &)
+    {
+        keep(evaluate());
+        return 1;
+    });
+
+
+    cout << endl;
+
+
+    return 0;
+}
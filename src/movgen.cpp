@@ -31,793 +31,341 @@ using namespace std;
 
 
 
-// generateMoves
+// pawnPush
 //
-// Generate all pseudo-legal moves for the current position.
-void generateMoves(MoveList_t &MoveList)
+// Shift a Bitboard of pawns (or squares) one rank forward from the given
+// side's point of view, plus the given file offset (-1 left, +1 right).
+template <int Side, int FileOffset = 0>
+static inline Bitboard pawnPush(Bitboard bb)
 {
-    int fromSq, toSq;
-    Bitboard attacks = 0ULL;
-
-
-    // Bitboard containing the pieces for the side on move
-    Bitboard Us = occupancies[sideToMove];
+    if constexpr (Side == White)
+        return (FileOffset < 0) ? ((bb & NotFileA_Mask) >> 9) :
+               (FileOffset > 0) ? ((bb & NotFileH_Mask) >> 7) : (bb >> 8);
+    else
+        return (FileOffset < 0) ? ((bb & NotFileA_Mask) << 7) :
+               (FileOffset > 0) ? ((bb & NotFileH_Mask) << 9) : (bb << 8);
+}
 
 
-    // start with an empty move list
-    MoveList.count = 0;
 
+// addPromotions
+//
+// Add the 4 possible promotions of a pawn move to the move list.
+static inline void addPromotions(MoveList_t &MoveList, int fromSq, int toSq)
+{
+    addMove(MoveList, encodePromo(fromSq, toSq, Q));
+    addMove(MoveList, encodePromo(fromSq, toSq, R));
+    addMove(MoveList, encodePromo(fromSq, toSq, B));
+    addMove(MoveList, encodePromo(fromSq, toSq, N));
+}
 
-    // iterate over all the pieces from the side on move
-    while (Us)
-    {
-        // get next piece and its location, then clean it from the "Us" Bitboard
-        fromSq = popLsb(Us);
 
 
-        // White Pawns
-        if (SqBB[fromSq] & bitboards[P])
-        {
-            // init target square
-            toSq = fromSq - 8;
+// generatePawnMoves
+//
+// Generate the pawn moves of the given side and type, set-wise: all the
+// pawns are pushed (or capture) at once with a single bitboard shift, and
+// the from square of every move is found back from its target square. Only
+// the moves to the given target squares are generated (except enpassant).
+template <int Side, GenType Type>
+static inline void generatePawnMoves(MoveList_t &MoveList, Bitboard targets)
+{
+    constexpr int Them       = Side ^ 1;
+    constexpr int Pawn       = Side * 6 + P;
+    constexpr int Up         = (Side == White) ? -8 : 8;
+    constexpr Bitboard Promo = (Side == White) ? Rank8_Mask : Rank1_Mask;
+    constexpr Bitboard Rank3 = (Side == White) ? Rank3_Mask : Rank6_Mask;
 
-            // generate quiet pawn moves
-            if (!(toSq < a8) && !getBit(occupancies[Both], toSq))
-            {
-                // pawn promotions
-                if (SqBB[toSq] & Rank8_Mask)
-                {                            
-                    addMove(MoveList, encodeMove(fromSq, toSq, P, Q, 0, 0, 0, 0));
-                    addMove(MoveList, encodeMove(fromSq, toSq, P, R, 0, 0, 0, 0));
-                    addMove(MoveList, encodeMove(fromSq, toSq, P, B, 0, 0, 0, 0));
-                    addMove(MoveList, encodeMove(fromSq, toSq, P, N, 0, 0, 0, 0));
-                }
-                
-                else
-                {
-                    // one-square pawn push
-                    addMove(MoveList, encodeMove(fromSq, toSq, P, 0, 0, 0, 0, 0));
-                    
-                    // double pawn push
-                    if ((SqBB[fromSq] & Rank2_Mask) && !(SqBB[toSq - 8] & occupancies[Both]))
-                        addMove(MoveList, encodeMove(fromSq, (toSq - 8), P, 0, 0, 1, 0, 0));
-                }
-            }
-                    
-            // init pawn attacks bitboard
-            attacks = PawnAttacks[White][fromSq] & occupancies[Black];
-            
-            // generate pawn captures
-            while (attacks)
-            {
-                // init target square
-                toSq = popLsb(attacks);
-                
-                // pawn promotions with capture
-                if (SqBB[toSq] & Rank8_Mask)
-                {
-                    addMove(MoveList, encodeMove(fromSq, toSq, P, Q, 1, 0, 0, 0));
-                    addMove(MoveList, encodeMove(fromSq, toSq, P, R, 1, 0, 0, 0));
-                    addMove(MoveList, encodeMove(fromSq, toSq, P, B, 1, 0, 0, 0));
-                    addMove(MoveList, encodeMove(fromSq, toSq, P, N, 1, 0, 0, 0));
-                }
-                
-                else
-                    // one-square pawn push
-                    addMove(MoveList, encodeMove(fromSq, toSq, P, 0, 1, 0, 0, 0));
-            }
-                    
-            // generate enpassant captures
-            if (epsq != NoSq)
-            {
-                // lookup pawn attacks and bitwise AND with enpassant square (bit)
-                Bitboard enpassant_attacks = PawnAttacks[White][fromSq] & (1ULL << epsq);
-                        
-                // make sure enpassant capture available
-                if (enpassant_attacks)
-                {
-                    // init enpassant capture target square
-                    int target_enpassant = ls1b(enpassant_attacks);
-                    addMove(MoveList, encodeMove(fromSq, target_enpassant, P, 0, 1, 0, 1, 0));
-                }
-            }
-        }
+    Bitboard pawns = bitboards[Pawn];
+    Bitboard empty = ~occupancies[Both];
+    Bitboard pushes, doubles, captures;
+    int toSq;
 
 
-        // Black Pawns
-        else if (SqBB[fromSq] & bitboards[p])
-        {
-            // init target square
-            toSq = fromSq + 8;
-            
-            // generate quiet pawn moves
-            if (!(toSq > h1) && !getBit(occupancies[Both], toSq))
-            {
-                // pawn promotions
-                if (SqBB[toSq] & Rank1_Mask)
-                {
-                    addMove(MoveList, encodeMove(fromSq, toSq, p, q, 0, 0, 0, 0));
-                    addMove(MoveList, encodeMove(fromSq, toSq, p, r, 0, 0, 0, 0));
-                    addMove(MoveList, encodeMove(fromSq, toSq, p, b, 0, 0, 0, 0));
-                    addMove(MoveList, encodeMove(fromSq, toSq, p, n, 0, 0, 0, 0));
-                }
-                
-                else
-                {
-                    // one-square pawn push
-                    addMove(MoveList, encodeMove(fromSq, toSq, p, 0, 0, 0, 0, 0));
-                    
-                    // double pawn push
-                    if ((SqBB[fromSq] & Rank7_Mask) && !(SqBB[toSq + 8] & occupancies[Both]))
-                        addMove(MoveList, encodeMove(fromSq, (toSq + 8), p, 0, 0, 1, 0, 0));
-                }
-            }
-            
-            // init pawn attacks bitboard
-            attacks = PawnAttacks[Black][fromSq] & occupancies[White];
-            
-            // generate pawn captures
-            while (attacks)
-            {
-                // init target square
-                toSq = popLsb(attacks);
-                
-                // pawn promotions with capture
-                if (SqBB[toSq] & Rank1_Mask)
-                {
-                    addMove(MoveList, encodeMove(fromSq, toSq, p, q, 1, 0, 0, 0));
-                    addMove(MoveList, encodeMove(fromSq, toSq, p, r, 1, 0, 0, 0));
-                    addMove(MoveList, encodeMove(fromSq, toSq, p, b, 1, 0, 0, 0));
-                    addMove(MoveList, encodeMove(fromSq, toSq, p, n, 1, 0, 0, 0));
-                }
-                
-                else
-                    // one-square ahead pawn move
-                    addMove(MoveList, encodeMove(fromSq, toSq, p, 0, 1, 0, 0, 0));
-            }
+    // single and double pawn pushes
+    pushes  = pawnPush<Side>(pawns) & empty;
+    doubles = pawnPush<Side>(pushes & Rank3) & empty & targets;
+    pushes &= targets;
 
-            // generate enpassant captures
-            if (epsq != NoSq)
-            {
-                // lookup pawn attacks and bitwise AND with enpassant square (bit)
-                Bitboard enpassant_attacks = PawnAttacks[Black][fromSq] & (1ULL << epsq);
-                
-                // make sure enpassant capture available
-                if (enpassant_attacks)
-                {
-                    // init enpassant capture target square
-                    int target_enpassant = ls1b(enpassant_attacks);
-                    addMove(MoveList, encodeMove(fromSq, target_enpassant, p, 0, 1, 0, 1, 0));
-                }
-            }
-        }
 
+    // promotions (with and without capture), in all the types except quiets
+    if constexpr (Type != GenQuiets)
+    {
+        Bitboard promotions = pushes & Promo;
 
-        // White Knights
-        else if (SqBB[fromSq] & bitboards[N])
+        while (promotions)
         {
-            // init piece attacks in order to get set of target squares
-            attacks = KnightAttacks[fromSq] & ~occupancies[White];
-            
-            // loop over target squares available from generated attacks
-            while (attacks)
-            {
-                // init target square
-                toSq = popLsb(attacks);    
-                
-                // quiet move
-                if (!(occupancies[Black] & SqBB[toSq]))
-                    addMove(MoveList, encodeMove(fromSq, toSq, N, 0, 0, 0, 0, 0));
-                
-                else
-                    // capture move
-                    addMove(MoveList, encodeMove(fromSq, toSq, N, 0, 1, 0, 0, 0));
-            }
+            toSq = popLsb(promotions);
+            addPromotions(MoveList, toSq - Up, toSq);
         }
 
 
-        // Black Knights
-        else if (SqBB[fromSq] & bitboards[n])
-        {
-            // init piece attacks in order to get set of target squares
-            attacks = KnightAttacks[fromSq] & ~occupancies[Black];
-            
-            // loop over target squares available from generated attacks
-            while (attacks)
-            {
-                // init target square
-                toSq = popLsb(attacks);    
-                
-                // quiet move
-                if (!(occupancies[White] & SqBB[toSq]))
-                    addMove(MoveList, encodeMove(fromSq, toSq, n, 0, 0, 0, 0, 0));
-                
-                else
-                    // capture move
-                    addMove(MoveList, encodeMove(fromSq, toSq, n, 0, 1, 0, 0, 0));
-            }
-        }
+        captures = pawnPush<Side, -1>(pawns) & occupancies[Them] & targets & Promo;
 
-
-        // White Bishops
-        else if (SqBB[fromSq] & bitboards[B])
+        while (captures)
         {
-            // init piece attacks in order to get set of target squares
-            attacks = getBishopAttacks(fromSq, occupancies[Both]) & ~occupancies[White];
-            
-            // loop over target squares available from generated attacks
-            while (attacks)
-            {
-                // init target square
-                toSq = popLsb(attacks);    
-                
-                // quiet move
-                if (!(occupancies[Black] & SqBB[toSq]))
-                    addMove(MoveList, encodeMove(fromSq, toSq, B, 0, 0, 0, 0, 0));
-                
-                else
-                    // capture move
-                    addMove(MoveList, encodeMove(fromSq, toSq, B, 0, 1, 0, 0, 0));
-            }
+            toSq = popLsb(captures);
+            addPromotions(MoveList, toSq - Up + 1, toSq);
         }
 
 
-        // Black Bishops
-        else if (SqBB[fromSq] & bitboards[b])
-        {
-            // init piece attacks in order to get set of target squares
-            attacks = getBishopAttacks(fromSq, occupancies[Both]) & ~occupancies[Black];
-            
-            // loop over target squares available from generated attacks
-            while (attacks)
-            {
-                // init target square
-                toSq = popLsb(attacks);    
-                
-                // quiet move
-                if (!(occupancies[White] & SqBB[toSq]))
-                    addMove(MoveList, encodeMove(fromSq, toSq, b, 0, 0, 0, 0, 0));
-                
-                else
-                    // capture move
-                    addMove(MoveList, encodeMove(fromSq, toSq, b, 0, 1, 0, 0, 0));
-            }
-        }
+        captures = pawnPush<Side, 1>(pawns) & occupancies[Them] & targets & Promo;
 
-
-        // White Rooks
-        else if (SqBB[fromSq] & bitboards[R])
+        while (captures)
         {
-            // init piece attacks in order to get set of target squares
-            attacks = getRookAttacks(fromSq, occupancies[Both]) & ~occupancies[White];
-            
-            // loop over target squares available from generated attacks
-            while (attacks)
-            {
-                // init target square
-                toSq = popLsb(attacks);    
-                
-                // quiet move
-                if (!(occupancies[Black] & SqBB[toSq]))
-                    addMove(MoveList, encodeMove(fromSq, toSq, R, 0, 0, 0, 0, 0));
-                
-                else
-                    // capture move
-                    addMove(MoveList, encodeMove(fromSq, toSq, R, 0, 1, 0, 0, 0));
-            }
+            toSq = popLsb(captures);
+            addPromotions(MoveList, toSq - Up - 1, toSq);
         }
+    }
 
 
-        // Black Rooks
-        else if (SqBB[fromSq] & bitboards[r])
+    // quiet pawn pushes (without promotion)
+    if constexpr (Type != GenCaptures)
+    {
+        pushes &= ~Promo;
+
+        while (pushes)
         {
-            // init piece attacks in order to get set of target squares
-            attacks = getRookAttacks(fromSq, occupancies[Both]) & ~occupancies[Black];
-            
-            // loop over target squares available from generated attacks
-            while (attacks)
-            {
-                // init target square
-                toSq = popLsb(attacks);    
-                
-                // quiet move
-                if (!(occupancies[White] & SqBB[toSq]))
-                    addMove(MoveList, encodeMove(fromSq, toSq, r, 0, 0, 0, 0, 0));
-                
-                else
-                    // capture move
-                    addMove(MoveList, encodeMove(fromSq, toSq, r, 0, 1, 0, 0, 0));
-            }
+            toSq = popLsb(pushes);
+            addMove(MoveList, encodeMove(toSq - Up, toSq, MoveFlagNormal));
         }
 
-
-        // White Queens
-        else if (SqBB[fromSq] & bitboards[Q])
+        while (doubles)
         {
-            // init piece attacks in order to get set of target squares
-            attacks = getQueenAttacks(fromSq, occupancies[Both]) & ~occupancies[White];
-            
-            // loop over target squares available from generated attacks
-            while (attacks)
-            {
-                // init target square
-                toSq = popLsb(attacks);    
-                
-                // quiet move
-                if (!(occupancies[Black] & SqBB[toSq]))
-                    addMove(MoveList, encodeMove(fromSq, toSq, Q, 0, 0, 0, 0, 0));
-                
-                else
-                    // capture move
-                    addMove(MoveList, encodeMove(fromSq, toSq, Q, 0, 1, 0, 0, 0));
-            }
+            toSq = popLsb(doubles);
+            addMove(MoveList, encodeMove(toSq - 2 * Up, toSq, MoveFlagNormal));
         }
+    }
 
 
-        // Black Queens
-        else if (SqBB[fromSq] & bitboards[q])
+    // pawn captures (without promotion) and enpassant captures
+    if constexpr (Type != GenQuiets)
+    {
+        captures = pawnPush<Side, -1>(pawns) & occupancies[Them] & targets & ~Promo;
+
+        while (captures)
         {
-            // init piece attacks in order to get set of target squares
-            attacks = getQueenAttacks(fromSq, occupancies[Both]) & ~occupancies[Black];
-            
-            // loop over target squares available from generated attacks
-            while (attacks)
-            {
-                // init target square
-                toSq = popLsb(attacks);    
-                
-                // quiet move
-                if (!(occupancies[White] & SqBB[toSq]))
-                    addMove(MoveList, encodeMove(fromSq, toSq, q, 0, 0, 0, 0, 0));
-                
-                else
-                    // capture move
-                    addMove(MoveList, encodeMove(fromSq, toSq, q, 0, 1, 0, 0, 0));
-            }
+            toSq = popLsb(captures);
+            addMove(MoveList, encodeMove(toSq - Up + 1, toSq, MoveFlagNormal));
         }
 
 
-        // White King
-        else if (SqBB[fromSq] & bitboards[K])
+        captures = pawnPush<Side, 1>(pawns) & occupancies[Them] & targets & ~Promo;
+
+        while (captures)
         {
-            // init piece attacks in order to get set of target squares
-            attacks = KingAttacks[fromSq] & ~occupancies[White];
-            
-            // loop over target squares available from generated attacks
-            while (attacks)
-            {
-                // init target square
-                toSq = popLsb(attacks);    
-                
-                // quiet move
-                if (!(occupancies[Black] & SqBB[toSq]))
-                    addMove(MoveList, encodeMove(fromSq, toSq, K, 0, 0, 0, 0, 0));
-                
-                else
-                    // capture move
-                    addMove(MoveList, encodeMove(fromSq, toSq, K, 0, 1, 0, 0, 0));
-            }
-                    
-            // short castle 0-0
-            if (castle & wk)
-            {
-                if (!(FG1_Mask & occupancies[Both]))
-                {
-                    if (!isSquareAttacked(e1, Black) &&
-                        !isSquareAttacked(f1, Black) &&
-                        !isSquareAttacked(g1, Black))
-                    {
-                        addMove(MoveList, encodeMove(e1, g1, K, 0, 0, 0, 0, 1));
-                    }
-                }
-            }
-            
-            // long castle 0-0-0
-            if (castle & wq)
-            {
-                if (!(DCB1_Mask & occupancies[Both]))
-                {
-                    if (!isSquareAttacked(e1, Black) &&
-                        !isSquareAttacked(d1, Black) &&
-                        !isSquareAttacked(c1, Black))
-                    {
-                        addMove(MoveList, encodeMove(e1, c1, K, 0, 0, 0, 0, 1));
-                    }
-                }
-            }
+            toSq = popLsb(captures);
+            addMove(MoveList, encodeMove(toSq - Up - 1, toSq, MoveFlagNormal));
         }
 
 
-        // Black King
-        else if (SqBB[fromSq] & bitboards[k])
+        // the pawns attacking the enpassant square are those that the
+        // opponent's pawns would attack from it
+        if (epsq != NoSq)
         {
-            // init piece attacks in order to get set of target squares
-            attacks = KingAttacks[fromSq] & ~occupancies[Black];
-            
-            // loop over target squares available from generated attacks
-            while (attacks)
-            {
-                // init target square
-                toSq = popLsb(attacks);    
-                
-                // quiet move
-                if (!(occupancies[White] & SqBB[toSq]))
-                    addMove(MoveList, encodeMove(fromSq, toSq, k, 0, 0, 0, 0, 0));
-                
-                else
-                    // capture move
-                    addMove(MoveList, encodeMove(fromSq, toSq, k, 0, 1, 0, 0, 0));
-            }
+            Bitboard attackers = PawnAttacks[Them][epsq] & pawns;
 
-            // short castle 0-0
-            if (castle & bk)
-            {
-                if (!(FG8_Mask & occupancies[Both]))
-                {
-                    if (!isSquareAttacked(e8, White) &&
-                        !isSquareAttacked(f8, White) &&
-                        !isSquareAttacked(g8, White))
-                    {
-                        addMove(MoveList, encodeMove(e8, g8, k, 0, 0, 0, 0, 1));
-                    }
-                }
-            }
-            
-            // long castle 0-0-0
-            if (castle & bq)
-            {
-                if (!(DCB8_Mask & occupancies[Both]))
-                {
-                    if (!isSquareAttacked(e8, White) &&
-                        !isSquareAttacked(d8, White) &&
-                        !isSquareAttacked(c8, White))
-                    {
-                        addMove(MoveList, encodeMove(e8, c8, k, 0, 0, 0, 0, 1));
-                    }
-                }
-            }
+            while (attackers)
+                addMove(MoveList, encodeMove(popLsb(attackers), epsq, MoveFlagEp));
         }
     }
 }
 
 
 
-// generateCapturesAndPromotions
+// addPieceMoves
 //
-// Generate all pseudo-legal captures and promotions for the current position.
-// This is typically used by the quiescence search.
-void generateCapturesAndPromotions(MoveList_t &MoveList)
+// Add the moves of a piece from the given square to every target square,
+// all of them either captures or quiet moves.
+static inline void addPieceMoves(MoveList_t &MoveList, int fromSq, Bitboard targets)
 {
-    int fromSq, toSq;
-    Bitboard captures = 0ULL;
+    while (targets)
+        addMove(MoveList, encodeMove(fromSq, popLsb(targets), MoveFlagNormal));
+}
 
 
-    // Bitboard containing the pieces for the side on move
-    Bitboard Us = occupancies[sideToMove];
 
+// generatePieceMoves
+//
+// Generate the moves of all the pieces of the given side and type (Knights,
+// Bishops, Rooks or Queens) to the given target squares.
+template <int Side, int Type>
+static inline void generatePieceMoves(MoveList_t &MoveList, Bitboard targets)
+{
+    constexpr int Them  = Side ^ 1;
+    constexpr int Piece = Side * 6 + Type;
 
-    // start with an empty move list
-    MoveList.count = 0;
+    Bitboard pieces = bitboards[Piece];
+    Bitboard attacks;
 
 
-    // iterate over all the pieces from the side on move
-    while (Us)
+    while (pieces)
     {
-        // get next piece and its location, then clean it from the "Us" Bitboard
-        fromSq = popLsb(Us);
+        int fromSq = popLsb(pieces);
+
+        if constexpr (Type == N)
+            attacks = KnightAttacks[fromSq];
+        else if constexpr (Type == B)
+            attacks = getBishopAttacks(fromSq, occupancies[Both]);
+        else if constexpr (Type == R)
+            attacks = getRookAttacks(fromSq, occupancies[Both]);
+        else
+            attacks = getQueenAttacks(fromSq, occupancies[Both]);
+
+        addPieceMoves(MoveList, fromSq, attacks & targets & occupancies[Them]);
+        addPieceMoves(MoveList, fromSq, attacks & targets & ~occupancies[Them]);
+    }
+}
 
 
-        // White Pawns
-        if (SqBB[fromSq] & bitboards[P])
-        {
-            // init target square
-            toSq = fromSq - 8;
 
-            // generate pawn promotions
-            if (!(toSq < a8) && !getBit(occupancies[Both], toSq))
-            {
-                // pawn promotions
-                if (SqBB[toSq] & Rank8_Mask)
-                {                            
-                    addMove(MoveList, encodeMove(fromSq, toSq, P, Q, 0, 0, 0, 0));
-                    addMove(MoveList, encodeMove(fromSq, toSq, P, R, 0, 0, 0, 0));
-                    addMove(MoveList, encodeMove(fromSq, toSq, P, B, 0, 0, 0, 0));
-                    addMove(MoveList, encodeMove(fromSq, toSq, P, N, 0, 0, 0, 0));
-                }
-            }
-                    
-            // init pawn attacks bitboard
-            captures = PawnAttacks[White][fromSq] & occupancies[Black];
-            
-            // generate pawn captures
-            while (captures)
-            {
-                // init target square
-                toSq = popLsb(captures);
-                
-                // pawn promotions with capture
-                if (SqBB[toSq] & Rank8_Mask)
-                {
-                    addMove(MoveList, encodeMove(fromSq, toSq, P, Q, 1, 0, 0, 0));
-                    addMove(MoveList, encodeMove(fromSq, toSq, P, R, 1, 0, 0, 0));
-                    addMove(MoveList, encodeMove(fromSq, toSq, P, B, 1, 0, 0, 0));
-                    addMove(MoveList, encodeMove(fromSq, toSq, P, N, 1, 0, 0, 0));
-                }
-                
-                // regular capture (without promotion)
-                else
-                    addMove(MoveList, encodeMove(fromSq, toSq, P, 0, 1, 0, 0, 0));
-            }
-                    
-            // generate enpassant captures
-            if (epsq != NoSq)
-            {
-                // lookup pawn attacks and bitwise AND with enpassant square (bit)
-                Bitboard ep_captures = PawnAttacks[White][fromSq] & (1ULL << epsq);
-                        
-                // make sure enpassant capture available
-                if (ep_captures)
-                {
-                    // init enpassant capture target square
-                    int target_enpassant = ls1b(ep_captures);
-                    addMove(MoveList, encodeMove(fromSq, target_enpassant, P, 0, 1, 0, 1, 0));
-                }
-            }
-        }
+// generateKingMoves
+//
+// Generate the King moves of the given side to the given target squares,
+// and the castling moves (in quiet and all moves generation only).
+template <int Side, GenType Type>
+static inline void generateKingMoves(MoveList_t &MoveList, Bitboard targets)
+{
+    constexpr int Them = Side ^ 1;
+    constexpr int King = Side * 6 + K;
 
+    int fromSq = ls1b(bitboards[King]);
+    Bitboard attacks = KingAttacks[fromSq] & targets;
 
-        // Black Pawns
-        else if (SqBB[fromSq] & bitboards[p])
-        {
-            // init target square
-            toSq = fromSq + 8;
-            
-            // generate pawn promotions
-            if (!(toSq > h1) && !getBit(occupancies[Both], toSq))
-            {
-                // pawn promotions
-                if (SqBB[toSq] & Rank1_Mask)
-                {
-                    addMove(MoveList, encodeMove(fromSq, toSq, p, q, 0, 0, 0, 0));
-                    addMove(MoveList, encodeMove(fromSq, toSq, p, r, 0, 0, 0, 0));
-                    addMove(MoveList, encodeMove(fromSq, toSq, p, b, 0, 0, 0, 0));
-                    addMove(MoveList, encodeMove(fromSq, toSq, p, n, 0, 0, 0, 0));
-                }
-            }
-            
-            // init pawn attacks bitboard
-            captures = PawnAttacks[Black][fromSq] & occupancies[White];
-            
-            // generate pawn captures
-            while (captures)
-            {
-                // init target square
-                toSq = popLsb(captures);
-                
-                // pawn promotions with capture
-                if (SqBB[toSq] & Rank1_Mask)
-                {
-                    addMove(MoveList, encodeMove(fromSq, toSq, p, q, 1, 0, 0, 0));
-                    addMove(MoveList, encodeMove(fromSq, toSq, p, r, 1, 0, 0, 0));
-                    addMove(MoveList, encodeMove(fromSq, toSq, p, b, 1, 0, 0, 0));
-                    addMove(MoveList, encodeMove(fromSq, toSq, p, n, 1, 0, 0, 0));
-                }
-                
-                // regular capture (without promotion)
-                else
-                    addMove(MoveList, encodeMove(fromSq, toSq, p, 0, 1, 0, 0, 0));
-            }
 
-            // generate enpassant captures
-            if (epsq != NoSq)
-            {
-                // lookup pawn attacks and bitwise AND with enpassant square (bit)
-                Bitboard ep_captures = PawnAttacks[Black][fromSq] & (1ULL << epsq);
-                
-                // make sure enpassant capture available
-                if (ep_captures)
-                {
-                    // init enpassant capture target square
-                    int target_enpassant = ls1b(ep_captures);
-                    addMove(MoveList, encodeMove(fromSq, target_enpassant, p, 0, 1, 0, 1, 0));
-                }
-            }
-        }
+    addPieceMoves(MoveList, fromSq, attacks & occupancies[Them]);
+    addPieceMoves(MoveList, fromSq, attacks & ~occupancies[Them]);
 
 
-        // White Knights
-        else if (SqBB[fromSq] & bitboards[N])
+    // castling moves: the squares between King and Rook must be empty, and
+    // the squares crossed by the King must not be attacked
+    if constexpr ((Type == GenQuiets) || (Type == GenAll))
+    {
+        constexpr int KingSide  = (Side == White) ? wk : bk;
+        constexpr int QueenSide = (Side == White) ? wq : bq;
+        constexpr int E         = (Side == White) ? e1 : e8;
+        constexpr int G         = (Side == White) ? g1 : g8;
+        constexpr int C         = (Side == White) ? c1 : c8;
+        constexpr Bitboard FG   = (Side == White) ? FG1_Mask : FG8_Mask;
+        constexpr Bitboard DCB  = (Side == White) ? DCB1_Mask : DCB8_Mask;
+
+        // short castle 0-0
+        if ((castle & KingSide) && !(FG & occupancies[Both]))
         {
-            // init piece attacks in order to get set of target squares
-            captures = KnightAttacks[fromSq] & occupancies[Black];
-            
-            // loop over target squares available from generated attacks
-            while (captures)
+            if (!isSquareAttacked(E, Them) &&
+                !isSquareAttacked(E + 1, Them) &&
+                !isSquareAttacked(E + 2, Them))
             {
-                // init target square
-                toSq = popLsb(captures);    
-                
-                // capture move
-                if (occupancies[Black] & SqBB[toSq])
-                    addMove(MoveList, encodeMove(fromSq, toSq, N, 0, 1, 0, 0, 0));
+                addMove(MoveList, encodeMove(E, G, MoveFlagCastling));
             }
         }
 
-
-        // Black Knights
-        else if (SqBB[fromSq] & bitboards[n])
+        // long castle 0-0-0
+        if ((castle & QueenSide) && !(DCB & occupancies[Both]))
         {
-            // init piece attacks in order to get set of target squares
-            captures = KnightAttacks[fromSq] & occupancies[White];
-            
-            // loop over target squares available from generated attacks
-            while (captures)
+            if (!isSquareAttacked(E, Them) &&
+                !isSquareAttacked(E - 1, Them) &&
+                !isSquareAttacked(E - 2, Them))
             {
-                // init target square
-                toSq = popLsb(captures);    
-                
-                // capture move
-                if (occupancies[White] & SqBB[toSq])
-                    addMove(MoveList, encodeMove(fromSq, toSq, n, 0, 1, 0, 0, 0));
+                addMove(MoveList, encodeMove(E, C, MoveFlagCastling));
             }
         }
+    }
+}
 
 
-        // White Bishops
-        else if (SqBB[fromSq] & bitboards[B])
-        {
-            // init piece attacks in order to get set of target squares
-            captures = getBishopAttacks(fromSq, occupancies[Both]) & occupancies[Black];
-            
-            // loop over target squares available from generated attacks
-            while (captures)
-            {
-                // init target square
-                toSq = popLsb(captures);    
-                
-                // capture move
-                if (occupancies[Black] & SqBB[toSq])
-                    addMove(MoveList, encodeMove(fromSq, toSq, B, 0, 1, 0, 0, 0));
-            }
-        }
 
+// generate
+//
+// Generate the pseudo-legal moves of the given type for the given side to
+// move, piece type by piece type:
+//
+// GenCaptures: captures (including enpassant) and promotions
+// GenQuiets:   non-capturing moves (including castling) but promotions
+// GenEvasions: all moves that might get the King out of check (in check)
+// GenAll:      all moves
+template <int Side, GenType Type>
+void generate(MoveList_t &MoveList)
+{
+    // reliability checks
+    assert(Side == sideToMove);
 
-        // Black Bishops
-        else if (SqBB[fromSq] & bitboards[b])
-        {
-            // init piece attacks in order to get set of target squares
-            captures = getBishopAttacks(fromSq, occupancies[Both]) & occupancies[White];
-            
-            // loop over target squares available from generated attacks
-            while (captures)
-            {
-                // init target square
-                toSq = popLsb(captures);    
-                
-                // capture move
-                if (occupancies[White] & SqBB[toSq])
-                    addMove(MoveList, encodeMove(fromSq, toSq, b, 0, 1, 0, 0, 0));
-            }
-        }
 
+    constexpr int Them = Side ^ 1;
 
-        // White Rooks
-        else if (SqBB[fromSq] & bitboards[R])
-        {
-            // init piece attacks in order to get set of target squares
-            captures = getRookAttacks(fromSq, occupancies[Both]) & occupancies[Black];
-            
-            // loop over target squares available from generated attacks
-            while (captures)
-            {
-                // init target square
-                toSq = popLsb(captures);    
-                
-                // capture move
-                if (occupancies[Black] & SqBB[toSq])
-                    addMove(MoveList, encodeMove(fromSq, toSq, R, 0, 1, 0, 0, 0));
-            }
-        }
+    Bitboard targets;
+    int kingSq = ls1b(bitboards[Side * 6 + K]);
 
 
-        // Black Rooks
-        else if (SqBB[fromSq] & bitboards[r])
-        {
-            // init piece attacks in order to get set of target squares
-            captures = getRookAttacks(fromSq, occupancies[Both]) & occupancies[White];
-            
-            // loop over target squares available from generated attacks
-            while (captures)
-            {
-                // init target square
-                toSq = popLsb(captures);    
-                
-                // capture move
-                if (occupancies[White] & SqBB[toSq])
-                    addMove(MoveList, encodeMove(fromSq, toSq, r, 0, 1, 0, 0, 0));
-            }
-        }
+    // start with an empty move list
+    MoveList.count = 0;
 
 
-        // White Queens
-        else if (SqBB[fromSq] & bitboards[Q])
-        {
-            // init piece attacks in order to get set of target squares
-            captures = getQueenAttacks(fromSq, occupancies[Both]) & occupancies[Black];
-            
-            // loop over target squares available from generated attacks
-            while (captures)
-            {
-                // init target square
-                toSq = popLsb(captures);    
-                
-                // capture move
-                if (occupancies[Black] & SqBB[toSq])
-                    addMove(MoveList, encodeMove(fromSq, toSq, Q, 0, 1, 0, 0, 0));
-            }
-        }
+    // target squares of the moves, depending on the type of generation
+    if constexpr (Type == GenCaptures)
+        targets = occupancies[Them];
+    else if constexpr (Type == GenQuiets)
+        targets = ~occupancies[Both];
+    else
+        targets = ~occupancies[Side];
 
 
-        // Black Queens
-        else if (SqBB[fromSq] & bitboards[q])
-        {
-            // init piece attacks in order to get set of target squares
-            captures = getQueenAttacks(fromSq, occupancies[Both]) & occupancies[White];
-            
-            // loop over target squares available from generated attacks
-            while (captures)
-            {
-                // init target square
-                toSq = popLsb(captures);    
-                
-                // capture move
-                if (occupancies[White] & SqBB[toSq])
-                    addMove(MoveList, encodeMove(fromSq, toSq, q, 0, 1, 0, 0, 0));
-            }
-        }
+    // in check, the other pieces can only capture the checker or block the
+    // check; with 2 checkers, only the King can move
+    if constexpr (Type == GenEvasions)
+    {
+        Bitboard checkers =
+            (PawnAttacks[Side][kingSq] & bitboards[Them * 6 + P])
+          | (KnightAttacks[kingSq] & bitboards[Them * 6 + N])
+          | (getBishopAttacks(kingSq, occupancies[Both]) & (bitboards[Them * 6 + B] | bitboards[Them * 6 + Q]))
+          | (getRookAttacks(kingSq, occupancies[Both]) & (bitboards[Them * 6 + R] | bitboards[Them * 6 + Q]));
 
+        assert(checkers);
 
-        // White King
-        else if (SqBB[fromSq] & bitboards[K])
+        if (countBits(checkers) > 1)
         {
-            // init piece attacks in order to get set of target squares
-            captures = KingAttacks[fromSq] & occupancies[Black];
-            
-            // loop over target squares available from generated attacks
-            while (captures)
-            {
-                // init target square
-                toSq = popLsb(captures);    
-                
-                // capture move
-                if (occupancies[Black] & SqBB[toSq])
-                    addMove(MoveList, encodeMove(fromSq, toSq, K, 0, 1, 0, 0, 0));
-            }
+            generateKingMoves<Side, Type>(MoveList, targets);
+            return;
         }
 
+        Bitboard kingTargets = targets;
+        targets &= checkers | getSquaresBetween(kingSq, ls1b(checkers));
 
-        // Black King
-        else if (SqBB[fromSq] & bitboards[k])
-        {
-            // init piece attacks in order to get set of target squares
-            captures = KingAttacks[fromSq] & occupancies[White];
-            
-            // loop over target squares available from generated attacks
-            while (captures)
-            {
-                // init target square
-                toSq = popLsb(captures);    
-                
-                // capture move
-                if (occupancies[White] & SqBB[toSq])
-                    addMove(MoveList, encodeMove(fromSq, toSq, k, 0, 1, 0, 0, 0));
-            }
-        }
+        generatePawnMoves<Side, Type>(MoveList, targets);
+        generatePieceMoves<Side, N>(MoveList, targets);
+        generatePieceMoves<Side, B>(MoveList, targets);
+        generatePieceMoves<Side, R>(MoveList, targets);
+        generatePieceMoves<Side, Q>(MoveList, targets);
+        generateKingMoves<Side, Type>(MoveList, kingTargets);
+    }
+
+    else
+    {
+        // promotions are generated with the captures, so pawns need all the
+        // empty squares as targets too
+        generatePawnMoves<Side, Type>(MoveList, (Type == GenCaptures) ? ~occupancies[Side] : targets);
+        generatePieceMoves<Side, N>(MoveList, targets);
+        generatePieceMoves<Side, B>(MoveList, targets);
+        generatePieceMoves<Side, R>(MoveList, targets);
+        generatePieceMoves<Side, Q>(MoveList, targets);
+        generateKingMoves<Side, Type>(MoveList, targets);
     }
 }
 
 
 
+// Explicit instantiations of the move generator, for both sides
+template void generate<White, GenCaptures>(MoveList_t &);
+template void generate<White, GenQuiets>(MoveList_t &);
+template void generate<White, GenEvasions>(MoveList_t &);
+template void generate<White, GenAll>(MoveList_t &);
+template void generate<Black, GenCaptures>(MoveList_t &);
+template void generate<Black, GenQuiets>(MoveList_t &);
+template void generate<Black, GenEvasions>(MoveList_t &);
+template void generate<Black, GenAll>(MoveList_t &);
+
+
+
 // printMoveList
 //
 // Print the list of generated pseudo-legal moves.
@@ -842,7 +390,7 @@ void printMoveList(MoveList_t &MoveList)
     for (int i = 0; i < MoveList.count; i++)
     {
         // init move
-        int move = MoveList.moves[i];
+        Move move = MoveList.moves[i].move;
 
         
         // print move and piece
@@ -31,12 +31,25 @@
 
 
 
+// ScoredMove_t is a move together with its score for move ordering. Both
+// are kept side by side, so that scoring and sorting a move list touches a
+// single array of 4-byte entries.
+//
+// @see scoreMove() and sortMoves()
+typedef struct
+{
+    Move    move;
+    int16_t score;
+} ScoredMove_t;
+
+
+
 // MoveList_t is a structure holding a list of moves (up to 256, which is
 // enough for any legal chess position), and a pointer to the last element,
 // which can also be used as a counter of elements in the move list.
 typedef struct
 {
-    int moves[256];
+    ScoredMove_t moves[256];
     int count;
 } MoveList_t;
 
@@ -44,62 +57,74 @@ typedef struct
 
 // Move encoding:
 //
-// Moves are encoded using 24 bits, where the following schema is followed:
+// Moves are encoded using 16 bits, where the following schema is followed:
 /*
-          binary move bits                               hexadecimal constants
+          binary move bits                     hexadecimal constants
     
-    0000 0000 0000 0000 0011 1111    source square       0x3f
-    0000 0000 0000 1111 1100 0000    target square       0xfc0
-    0000 0000 1111 0000 0000 0000    piece               0xf000
-    0000 1111 0000 0000 0000 0000    promoted piece      0xf0000
-    0001 0000 0000 0000 0000 0000    capture flag        0x100000
-    0010 0000 0000 0000 0000 0000    double push flag    0x200000
-    0100 0000 0000 0000 0000 0000    enpassant flag      0x400000
-    1000 0000 0000 0000 0000 0000    castling flag       0x800000
+    0000 0000 0011 1111    source square       0x3f
+    0000 1111 1100 0000    target square       0xfc0
+    0011 0000 0000 0000    move flag           0x3000
+    1100 0000 0000 0000    promoted piece      0xc000
 */
+//
+// The move flag tells apart promotions, enpassant captures and castling
+// from the rest of moves, and the promoted piece is stored as N, B, R or Q
+// (minus N). Everything else (the piece moved, whether it's a capture or a
+// double pawn push, the color of the promoted piece) is read from the board,
+// so these properties are only valid before the move is made.
+#define MoveFlagNormal           0x0000
+#define MoveFlagPromo            0x1000
+#define MoveFlagEp               0x2000
+#define MoveFlagCastling         0x3000
+
+
 
-// Encode move macro
-#define encodeMove(fromSq, toSq, piece, promo, capture, double, ep, castling) \
-    (fromSq) |          \
-    (toSq << 6) |       \
-    (piece << 12) |     \
-    (promo << 16) |     \
-    (capture << 20) |   \
-    (double << 21) |    \
-    (ep << 22) |        \
-    (castling << 23)    \
+// Encode move macros
+#define encodeMove(fromSq, toSq, flag) \
+    ((fromSq) | ((toSq) << 6) | (flag))
+
+#define encodePromo(fromSq, toSq, promo) \
+    ((fromSq) | ((toSq) << 6) | MoveFlagPromo | ((((promo) % 6) - N) << 14))
 
 
 // Extract source square
-#define getMoveSource(move) (move & 0x3f)
+#define getMoveSource(move) ((move) & 0x3f)
 
 
 // Extract target square
-#define getMoveTarget(move) ((move & 0xfc0) >> 6)
+#define getMoveTarget(move) (((move) & 0xfc0) >> 6)
+
 
+// Extract move flag
+#define getMoveFlag(move) ((move) & 0x3000)
 
-// Extract piece
-#define getMovePiece(move) ((move & 0xf000) >> 12)
 
+// Extract piece (from the board)
+#define getMovePiece(move) pieceOn(getMoveSource(move))
 
-// Extract promoted piece
-#define getPromo(move) ((move & 0xf0000) >> 16)
 
+// Extract promoted piece, of the color of the side to move
+#define getPromo(move) ((getMoveFlag(move) == MoveFlagPromo) ? \
+    (((move) >> 14) + N + ((sideToMove == White) ? P : p)) : 0)
 
-// Extract capture flag
-#define getMoveCapture(move) (move & 0x100000)
 
+// Extract capture flag (from the board)
+#define getMoveCapture(move) \
+    (getEp(move) || (occupancies[Both] & SqBB[getMoveTarget(move)]))
 
-// Extract double pawn push flag
-#define getDoublePush(move) (move & 0x200000)
+
+// Extract double pawn push flag (from the board)
+#define getDoublePush(move) \
+    (((getMoveTarget(move) ^ getMoveSource(move)) == 16) && \
+     (bitboards[(sideToMove == White) ? P : p] & SqBB[getMoveSource(move)]))
 
 
 // Extract enpassant flag
-#define getEp(move) (move & 0x400000)
+#define getEp(move) (getMoveFlag(move) == MoveFlagEp)
 
 
 // Extract castling flag
-#define getCastle(move) (move & 0x800000)
+#define getCastle(move) (getMoveFlag(move) == MoveFlagCastling)
 
 
 
@@ -137,17 +162,62 @@ static constexpr int castling_rights[64] =
 
 
 
+// Types of move generation (@see generate())
+enum GenType { GenCaptures, GenQuiets, GenEvasions, GenAll };
+
+
+
 // Functionality to generate and manipulate chess moves.
-void generateMoves(MoveList_t &);
-void generateCapturesAndPromotions(MoveList_t &);
+template <int Side, GenType Type> void generate(MoveList_t &);
 void printMoveList(MoveList_t &);
 
 
 
+// generateMoves
+//
+// Generate all pseudo-legal moves for the current position.
+static inline void generateMoves(MoveList_t &MoveList)
+{
+    if (sideToMove == White)
+        generate<White, GenAll>(MoveList);
+    else
+        generate<Black, GenAll>(MoveList);
+}
+
+
+
+// generateCapturesAndPromotions
+//
+// Generate all pseudo-legal captures and promotions for the current position.
+// This is typically used by the quiescence search.
+static inline void generateCapturesAndPromotions(MoveList_t &MoveList)
+{
+    if (sideToMove == White)
+        generate<White, GenCaptures>(MoveList);
+    else
+        generate<Black, GenCaptures>(MoveList);
+}
+
+
+
+// generateEvasions
+//
+// Generate the pseudo-legal moves that might get the King of the side to
+// move out of check (the side to move must be in check).
+static inline void generateEvasions(MoveList_t &MoveList)
+{
+    if (sideToMove == White)
+        generate<White, GenEvasions>(MoveList);
+    else
+        generate<Black, GenEvasions>(MoveList);
+}
+
+
+
 // prettyMove
 //
 // Generate a string with the move in UCI notation.
-static inline std::string prettyMove(int move)
+static inline std::string prettyMove(Move move)
 {
     // string stream where to write the move to
     std::stringstream ss;
@@ -170,7 +240,7 @@ static inline std::string prettyMove(int move)
 // printMove
 //
 // Print a move in UCI notation.
-static inline void printMove(int move)
+static inline void printMove(Move move)
 {
     std::cout << prettyMove(move);
 }
@@ -180,14 +250,14 @@ static inline void printMove(int move)
 // addMove
 //
 // Add a move to a move list.
-static inline void addMove(MoveList_t &MoveList, int move)
+static inline void addMove(MoveList_t &MoveList, Move move)
 {
     // reliability checks
     assert(MoveList.count >= 0);
 
 
     // strore move
-    MoveList.moves[MoveList.count] = move;
+    MoveList.moves[MoveList.count].move = move;
 
     
     // increment move count
@@ -245,6 +315,205 @@ constexpr bool isSquareAttacked(int square, int side)
 
 
 
+// CheckInfo_t is a structure holding what is needed to tell whether a move of
+// the side to move gives check, or leaves its own King in check, before the
+// move is made:
+//
+// - checkSquares: the squares from which each type of piece (P to K) would
+//   attack the enemy King;
+// - discoverers: own pieces that are the only piece between one of our
+//   sliders and the enemy King (moving them away gives a discovered check);
+// - pinned: own pieces that are the only piece between an enemy slider and
+//   our King.
+//
+// @see setCheckInfo(), givesCheck() and isLegal()
+typedef struct
+{
+    Bitboard checkSquares[6];
+    Bitboard discoverers;
+    Bitboard pinned;
+    int      kingSq;
+    int      enemyKingSq;
+} CheckInfo_t;
+
+
+
+// getBlockers
+//
+// Generate a Bitboard with the pieces (of any color) that stand alone between
+// the given square and one of the given sliders, moving along diagonals
+// (Bishops and Queens) or along ranks and files (Rooks and Queens).
+static inline Bitboard getBlockers(int square, Bitboard diagonal, Bitboard straight)
+{
+    Bitboard blockers = 0ULL;
+    Bitboard snipers = (getBishopAttacks(square, 0ULL) & diagonal) |
+                       (getRookAttacks(square, 0ULL) & straight);
+
+    while (snipers)
+    {
+        Bitboard between = getSquaresBetween(square, popLsb(snipers)) & occupancies[Both];
+
+        if (between && !(between & (between - 1)))
+            blockers |= between;
+    }
+
+
+    return blockers;
+}
+
+
+
+// staysOnLine
+//
+// For a move whose source square is on a line (rank, file or diagonal) with
+// the given square, and whose target square is not beyond it, tell whether
+// the move stays on that line.
+static inline bool staysOnLine(int fromSq, int toSq, int square)
+{
+    return (getSquaresBetween(fromSq, square) & SqBB[toSq]) ||
+           (getSquaresBetween(toSq, square) & SqBB[fromSq]);
+}
+
+
+
+// setCheckInfo
+//
+// Compute the check squares, discovered check candidates and pinned pieces of
+// the side to move, once per node, for givesCheck() and isLegal().
+static inline void setCheckInfo(CheckInfo_t &ci)
+{
+    // own pieces are [Us, Us + 5], enemy pieces are [Them, Them + 5]
+    int Us   = (sideToMove == White) ? P : p;
+    int Them = (sideToMove == White) ? p : P;
+
+
+    ci.kingSq      = ls1b(bitboards[Us + K]);
+    ci.enemyKingSq = ls1b(bitboards[Them + K]);
+
+
+    // squares from which each piece would attack the enemy King
+    ci.checkSquares[P] = PawnAttacks[sideToMove ^ 1][ci.enemyKingSq];
+    ci.checkSquares[N] = KnightAttacks[ci.enemyKingSq];
+    ci.checkSquares[B] = getBishopAttacks(ci.enemyKingSq, occupancies[Both]);
+    ci.checkSquares[R] = getRookAttacks(ci.enemyKingSq, occupancies[Both]);
+    ci.checkSquares[Q] = ci.checkSquares[B] | ci.checkSquares[R];
+    ci.checkSquares[K] = 0ULL;
+
+
+    // own pieces blocking our sliders (discoverers) or the enemy's (pinned)
+    ci.discoverers = getBlockers(ci.enemyKingSq, bitboards[Us + B] | bitboards[Us + Q],
+                                                 bitboards[Us + R] | bitboards[Us + Q]) &
+                     occupancies[sideToMove];
+
+    ci.pinned = getBlockers(ci.kingSq, bitboards[Them + B] | bitboards[Them + Q],
+                                       bitboards[Them + R] | bitboards[Them + Q]) &
+                occupancies[sideToMove];
+}
+
+
+
+// givesCheck
+//
+// True if the given (legal) move of the side to move checks the enemy King.
+// This is answered with a few bitboard tests, without making the move.
+static inline bool givesCheck(Move move, const CheckInfo_t &ci)
+{
+    int fromSq = getMoveSource(move);
+    int toSq   = getMoveTarget(move);
+    int Us     = (sideToMove == White) ? P : p;
+
+
+    // direct check (promotions are handled below, as the pawn disappears)
+    if (!getPromo(move) && (ci.checkSquares[getMovePiece(move) - Us] & SqBB[toSq]))
+        return true;
+
+
+    // discovered check, unless the piece keeps blocking the line
+    if ((ci.discoverers & SqBB[fromSq]) && !staysOnLine(fromSq, toSq, ci.enemyKingSq))
+        return true;
+
+
+    // only promotions, en passant captures and castling can give check in
+    // other ways
+    if (!getPromo(move) && !getEp(move) && !getCastle(move))
+        return false;
+
+
+    Bitboard occupancy = (occupancies[Both] ^ SqBB[fromSq]) | SqBB[toSq];
+
+
+    // the promoted piece may attack through the square the pawn just left
+    if (getPromo(move))
+        switch (getPromo(move) - Us)
+        {
+            case N:  return KnightAttacks[toSq] & SqBB[ci.enemyKingSq];
+            case B:  return getBishopAttacks(toSq, occupancy) & SqBB[ci.enemyKingSq];
+            case R:  return getRookAttacks(toSq, occupancy) & SqBB[ci.enemyKingSq];
+            default: return getQueenAttacks(toSq, occupancy) & SqBB[ci.enemyKingSq];
+        }
+
+
+    // en passant captures may uncover a slider through the captured pawn
+    if (getEp(move))
+    {
+        occupancy ^= SqBB[(sideToMove == White) ? toSq + 8 : toSq - 8];
+
+        return (getBishopAttacks(ci.enemyKingSq, occupancy) & (bitboards[Us + B] | bitboards[Us + Q])) ||
+               (getRookAttacks(ci.enemyKingSq, occupancy) & (bitboards[Us + R] | bitboards[Us + Q]));
+    }
+
+
+    // castling: the Rook may give check from its new square
+    int rookFrom = (toSq > fromSq) ? toSq + 1 : toSq - 2;
+    int rookTo   = (toSq > fromSq) ? toSq - 1 : toSq + 1;
+
+    occupancy = (occupancy ^ SqBB[rookFrom]) | SqBB[rookTo];
+
+    return getRookAttacks(rookTo, occupancy) & SqBB[ci.enemyKingSq];
+}
+
+
+
+// isLegal
+//
+// True if the given pseudo-legal move doesn't leave the King of the side to
+// move in check. This is answered without making the move, but only when the
+// side to move is not in check (evasions must be made to be verified).
+static inline bool isLegal(Move move, const CheckInfo_t &ci)
+{
+    // reliability checks
+    assert(!isSquareAttacked(ci.kingSq, sideToMove ^ 1));
+
+
+    int fromSq = getMoveSource(move);
+    int toSq   = getMoveTarget(move);
+    int Them   = (sideToMove == White) ? p : P;
+
+
+    // King moves: the generator already checked the squares crossed when
+    // castling; otherwise, as the King is not in check, no slider attacks
+    // through its square and the target square can be tested as it is
+    if (fromSq == ci.kingSq)
+        return getCastle(move) || !isSquareAttacked(toSq, sideToMove ^ 1);
+
+
+    // en passant captures: both pawns leave their rank at once
+    if (getEp(move))
+    {
+        Bitboard occupancy = (occupancies[Both] ^ SqBB[fromSq] ^
+                              SqBB[(sideToMove == White) ? toSq + 8 : toSq - 8]) | SqBB[toSq];
+
+        return !(getBishopAttacks(ci.kingSq, occupancy) & (bitboards[Them + B] | bitboards[Them + Q])) &&
+               !(getRookAttacks(ci.kingSq, occupancy) & (bitboards[Them + R] | bitboards[Them + Q]));
+    }
+
+
+    // other pieces may only move along the line they are pinned on
+    return !(ci.pinned & SqBB[fromSq]) || staysOnLine(fromSq, toSq, ci.kingSq);
+}
+
+
+
 // saveBoard
 //
 // Implemented as a macro, it's job is to preserve the current board state
@@ -252,11 +521,15 @@ constexpr bool isSquareAttacked(int square, int side)
 #define saveBoard()                                                       \
     Bitboard bitboards_copy[12], occupancies_copy[3];                     \
     int side_copy, enpassant_copy, castle_copy, fifty_copy;               \
+    int plies_from_null_copy;                                             \
     memcpy(bitboards_copy, bitboards, sizeof(bitboards));                 \
     memcpy(occupancies_copy, occupancies, sizeof(occupancies));           \
     side_copy = sideToMove, enpassant_copy = epsq, castle_copy = castle;  \
-    fifty_copy = fifty;                                                   \
+    fifty_copy = fifty, plies_from_null_copy = pliesFromNull;             \
     uint64_t hash_key_copy = hash_key;                                    \
+    uint8_t piece_count_copy[12];                                         \
+    memcpy(piece_count_copy, pieceCount, sizeof(pieceCount));             \
+    uint64_t material_key_copy = material_key;                            \
 
 
 
@@ -269,8 +542,10 @@ constexpr bool isSquareAttacked(int square, int side)
     memcpy(bitboards, bitboards_copy, sizeof(bitboards));                 \
     memcpy(occupancies, occupancies_copy, sizeof(occupancies));           \
     sideToMove = side_copy, epsq = enpassant_copy, castle = castle_copy;  \
-    fifty = fifty_copy;                                                   \
+    fifty = fifty_copy, pliesFromNull = plies_from_null_copy;             \
     hash_key = hash_key_copy;                                             \
+    memcpy(pieceCount, piece_count_copy, sizeof(pieceCount));             \
+    material_key = material_key_copy;                                     \
 
 
 
@@ -280,7 +555,7 @@ constexpr bool isSquareAttacked(int square, int side)
 //
 // Note: remember to save the board status (saveBoard) before calling
 //       makeMove(), if you then want to be able to use takeBack().
-static inline int makeMove(int move)
+static inline int makeMove(Move move)
 {
     //reliability checks
     assert(move);
@@ -318,9 +593,13 @@ static inline int makeMove(int move)
     hash_key ^= piece_keys[piece][fromSq] ^ piece_keys[piece][toSq];
 
 
-    // increment fifty move rule counter
+    // update fifty move rule counter: pawn moves reset it
     if ((piece != P) && (piece != p))
         fifty++;
+    else
+        fifty = 0;
+
+    pliesFromNull++;
 
 
     // handle castling moves
@@ -433,6 +712,9 @@ static inline int makeMove(int move)
                 // remove the piece from hash key
                 hash_key ^= piece_keys[bb_piece][toSq];
 
+                // remove the piece from the material
+                material_key ^= material_keys[bb_piece][--pieceCount[bb_piece]];
+
                 break;
             }
         }
@@ -452,6 +734,9 @@ static inline int makeMove(int move)
 
                 // remove pawn from hash key
                 hash_key ^= piece_keys[p][toSq + 8];
+
+                // remove pawn from the material
+                material_key ^= material_keys[p][--pieceCount[p]];
             }
            
 
@@ -466,6 +751,9 @@ static inline int makeMove(int move)
 
                 // remove pawn from hash key
                 hash_key ^= piece_keys[P][toSq - 8];
+
+                // remove pawn from the material
+                material_key ^= material_keys[P][--pieceCount[P]];
             }
         }
     }
@@ -482,6 +770,9 @@ static inline int makeMove(int move)
 
             // remove pawn from hash key
             hash_key ^= piece_keys[P][toSq];
+
+            // remove pawn from the material
+            material_key ^= material_keys[P][--pieceCount[P]];
         }
 
         
@@ -493,6 +784,9 @@ static inline int makeMove(int move)
             
             // remove pawn from hash key
             hash_key ^= piece_keys[p][toSq];
+
+            // remove pawn from the material
+            material_key ^= material_keys[p][--pieceCount[p]];
         }
 
         
@@ -502,6 +796,10 @@ static inline int makeMove(int move)
         
         // add promoted piece into the hash key
         hash_key ^= piece_keys[promo][toSq];
+
+
+        // add promoted piece to the material
+        material_key ^= material_keys[promo][pieceCount[promo]++];
     }
 
 
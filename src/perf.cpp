@@ -0,0 +1,203 @@
+/*
+  This file is part of Gargantua, a UCI chess engine with NNUE evaluation
+  derived from Chess0, and inspired by Code Monkey King's bbc-1.4.
+
+  Copyright (C) 2025 Claudio M. Camacho
+
+  Gargantua is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Gargantua is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstring>
+
+#ifdef __linux__
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+#include "perf.h"
+
+
+
+// File descriptors of the counters opened (-1 if unavailable), and their
+// values at the last stop()
+static int      fds[PerfCounters]    = { -1, -1, -1, -1, -1, -1 };
+static uint64_t values[PerfCounters] = {};
+
+
+
+// Names of the counters, as reported by bench
+static const char *names[PerfCounters] =
+{
+    "Cycles", "Instructions", "L1D misses", "LLC misses", "Branch misses", "dTLB misses"
+};
+
+
+
+#ifdef __linux__
+
+// Type and configuration of every counter for perf_event_open(2)
+#define CacheMiss(cache) \
+    (PERF_COUNT_HW_CACHE_##cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+static const uint32_t types[PerfCounters] =
+{
+    PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE,
+    PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE
+};
+
+static const uint64_t configs[PerfCounters] =
+{
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, CacheMiss(L1D),
+    CacheMiss(LL), PERF_COUNT_HW_BRANCH_MISSES, CacheMiss(DTLB)
+};
+
+
+
+// readCounter
+//
+// Read the value of a counter, scaled up if the kernel had to multiplex it
+// with other counters (i.e., it was only counting part of the time).
+static uint64_t readCounter(int fd)
+{
+    // value, time enabled and time running
+    uint64_t data[3] = {};
+
+    if (read(fd, data, sizeof(data)) != sizeof(data))
+        return 0ULL;
+
+    if (data[2] && (data[2] < data[1]))
+        return uint64_t(double(data[0]) * data[1] / data[2]);
+
+    return data[0];
+}
+
+#endif  //  __linux__
+
+
+
+// Perf::open
+//
+// Open all the counters, disabled and reset, counting the user space of this
+// process (and of the threads it creates). Return true if any is available.
+bool Perf::open()
+{
+    Perf::close();
+
+    bool any = false;
+
+#ifdef __linux__
+    for (int i = 0; i < PerfCounters; i++)
+    {
+        struct perf_event_attr attr;
+
+        memset(&attr, 0, sizeof(attr));
+        attr.size           = sizeof(attr);
+        attr.type           = types[i];
+        attr.config         = configs[i];
+        attr.disabled       = 1;
+        attr.inherit        = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+        attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        fds[i] = int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        any   |= (fds[i] >= 0);
+    }
+#endif
+
+    return any;
+}
+
+
+
+// Perf::close
+//
+// Close all the counters, and reset their values.
+void Perf::close()
+{
+    for (int i = 0; i < PerfCounters; i++)
+    {
+#ifdef __linux__
+        if (fds[i] >= 0)
+            ::close(fds[i]);
+#endif
+
+        fds[i]    = -1;
+        values[i] = 0ULL;
+    }
+}
+
+
+
+// Perf::start
+//
+// Start (or resume) counting. The counters keep their values between every
+// stop() and the next start(), so that only the code in between is measured.
+void Perf::start()
+{
+#ifdef __linux__
+    for (int i = 0; i < PerfCounters; i++)
+        if (fds[i] >= 0)
+            ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+#endif
+}
+
+
+
+// Perf::stop
+//
+// Stop counting and read the values counted so far.
+void Perf::stop()
+{
+#ifdef __linux__
+    for (int i = 0; i < PerfCounters; i++)
+        if (fds[i] >= 0)
+        {
+            ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+            values[i] = readCounter(fds[i]);
+        }
+#endif
+}
+
+
+
+// Perf::available
+//
+// Return true if the given counter could be opened.
+bool Perf::available(int counter)
+{
+    return fds[counter] >= 0;
+}
+
+
+
+// Perf::value
+//
+// Return the value of the given counter at the last stop().
+uint64_t Perf::value(int counter)
+{
+    return values[counter];
+}
+
+
+
+// Perf::name
+//
+// Return the name of the given counter.
+const char *Perf::name(int counter)
+{
+    return names[counter];
+}
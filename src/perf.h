@@ -0,0 +1,62 @@
+/*
+  This file is part of Gargantua, a UCI chess engine with NNUE evaluation
+  derived from Chess0, and inspired by Code Monkey King's bbc-1.4.
+
+  Copyright (C) 2025 Claudio M. Camacho
+
+  Gargantua is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Gargantua is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PERF_H
+#define PERF_H
+
+#include <cstdint>
+
+
+
+// Hardware performance counters measured by 'bench perf'
+enum PerfCounter
+{
+    PerfCycles,
+    PerfInstructions,
+    PerfL1DMisses,
+    PerfLLCMisses,
+    PerfBranchMisses,
+    PerfDTLBMisses,
+    PerfCounters
+};
+
+
+
+// Hardware performance counters interface, based on Linux's
+// perf_event_open(2). Each counter is opened on its own, so that the
+// counters not supported by the CPU (or the kernel, or forbidden in a
+// container) are simply reported as unavailable while the rest still work.
+// On other systems, no counter is ever available.
+namespace Perf
+{
+
+bool open();
+void close();
+void start();
+void stop();
+bool available(int);
+uint64_t value(int);
+const char *name(int);
+
+}  //  namespace Perf
+
+
+
+#endif  //  PERF_H
@@ -23,6 +23,7 @@
 #include <sstream>
 #include <cstring>
 #include <map>
+#include <utility>
 
 #include "bitboard.h"
 #include "position.h"
@@ -43,18 +44,28 @@ using namespace std;
 // 4. The castling rights
 // 5. The 50-move rule (50 moves without captures, pawn moves nor promotions)
 // 6. A ply counter (to separate root moves from the rest)
-Bitboard bitboards[12];
-Bitboard occupancies[3];
-int sideToMove = White;
-int epsq = NoSq; 
-int castle;
-int fifty = 0;
-int ply = 0;
+//
+// The position is thread-local, so that every thread can work on its own copy
+// of the board (e.g., a parallel perft).
+thread_local constinit Bitboard bitboards[12];
+thread_local constinit Bitboard occupancies[3];
+thread_local constinit int sideToMove = White;
+thread_local constinit int epsq = NoSq; 
+thread_local constinit int castle;
+thread_local constinit int fifty = 0;
+thread_local constinit int ply = 0;
+thread_local constinit int pliesFromNull = 0;
 
 
 
 // Chess position's (almost) unique hash key
-uint64_t hash_key = 0ULL;
+thread_local constinit uint64_t hash_key = 0ULL;
+
+
+
+// Piece counts and material key
+thread_local constinit uint8_t pieceCount[12];
+thread_local constinit uint64_t material_key = 0ULL;
 
 
 
@@ -65,8 +76,14 @@ bool flip = false;
 
 
 // Structures to detect 3-fold repetitions within the game:
-Bitboard repetition_table[1024];
-int repetition_index;
+thread_local constinit Bitboard repetition_table[1024];
+thread_local constinit int repetition_index;
+
+
+
+// Cuckoo tables of reversible moves (shared by all threads)
+uint64_t cuckoo[CuckooSize];
+uint16_t cuckooMove[CuckooSize];
 
 
 
@@ -95,8 +112,14 @@ void resetBoard()
     hash_key = 0ULL;
 
 
-    // reset fifty move rule counter
+    // reset piece counts and material key
+    memset(pieceCount, 0, sizeof(pieceCount));
+    material_key = 0ULL;
+
+
+    // reset fifty move rule counter and plies since the last null move
     fifty = 0;
+    pliesFromNull = 0;
 
 
     // reset repetition table
@@ -249,6 +272,13 @@ void setPosition(const string &fenStr)
 
     // init hash key
     hash_key = generateHashkey();
+
+
+    // init piece counts and material key
+    for (int piece = P; piece <= k; piece++)
+        pieceCount[piece] = countBits(bitboards[piece]);
+
+    material_key = generateMaterialKey();
 }
 
 
@@ -375,6 +405,68 @@ string getFEN()
 
 
 
+// initCuckoo
+//
+// Initialize the cuckoo tables with the keys of all the reversible moves,
+// i.e., every move of a piece (not a pawn) from one square to another on an
+// empty board. Both directions of a move share the same key, so only one of
+// them is stored.
+void initCuckoo()
+{
+    // reset the tables
+    memset(cuckoo, 0, sizeof(cuckoo));
+    memset(cuckooMove, 0, sizeof(cuckooMove));
+
+
+    for (int piece = P; piece <= k; piece++)
+    {
+        // pawn moves are irreversible
+        if ((piece == P) || (piece == p))
+            continue;
+
+        for (int square1 = 0; square1 < 64; square1++)
+        {
+            Bitboard attacks;
+
+            switch (piece % 6)
+            {
+                case N: attacks = KnightAttacks[square1]; break;
+                case B: attacks = getBishopAttacks(square1, 0ULL); break;
+                case R: attacks = getRookAttacks(square1, 0ULL); break;
+                case Q: attacks = getQueenAttacks(square1, 0ULL); break;
+                default: attacks = KingAttacks[square1]; break;
+            }
+
+            for (int square2 = square1 + 1; square2 < 64; square2++)
+            {
+                if (!(attacks & SqBB[square2]))
+                    continue;
+
+
+                // insert the move, displacing any other move in its way to
+                // its alternative slot, until an empty slot is found
+                uint64_t key = piece_keys[piece][square1] ^ piece_keys[piece][square2] ^ side_key;
+                uint16_t move = square1 | (square2 << 6);
+                int slot = CuckooH1(key);
+
+                while (true)
+                {
+                    swap(cuckoo[slot], key);
+                    swap(cuckooMove[slot], move);
+
+                    // empty slot found (square2 > 0, so no move is ever 0)
+                    if (move == 0)
+                        break;
+
+                    slot = (slot == int(CuckooH1(key))) ? CuckooH2(key) : CuckooH1(key);
+                }
+            }
+        }
+    }
+}
+
+
+
 // printBoard
 //
 // Convert the internal representation of the board into a human-readable string
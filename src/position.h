@@ -22,9 +22,12 @@
 #define POSITION_H
 
 #include <iostream>
+#include <algorithm>
 #include <map>
 #include <cstring>
 
+#include "material.h"
+
 
 
 // List of useful FEN positions used for testing and debbuging purposes
@@ -110,18 +113,37 @@ static std::map<int, unsigned char> PromoPieces = {
 // 3. The enpassant capture square
 // 4. The castling rights
 // 5. The 50-move rule counter
-extern Bitboard bitboards[12];
-extern Bitboard occupancies[3];
-extern int sideToMove;
-extern int epsq;
-extern int castle;
-extern int fifty;
-extern int ply;
+//
+// Every thread has its own copy of the position. The variables are declared
+// constinit (statically initialized), so that accessing them is as cheap as
+// accessing any other global variable.
+extern thread_local constinit Bitboard bitboards[12];
+extern thread_local constinit Bitboard occupancies[3];
+extern thread_local constinit int sideToMove;
+extern thread_local constinit int epsq;
+extern thread_local constinit int castle;
+extern thread_local constinit int fifty;
+extern thread_local constinit int ply;
+
+
+
+// Number of plies since the last null move of the search (or since the
+// position was set up); no position before a null move can be repeated
+// after it, so together with fifty, this bounds the repetition scans.
+extern thread_local constinit int pliesFromNull;
 
 
 
 // Every chess position has its own (almost) unique hash key:
-extern uint64_t hash_key;
+extern thread_local constinit uint64_t hash_key;
+
+
+
+// Number of pieces of every type on the board, and the material key: a hash
+// key of the material (piece counts) alone, used to look up the material
+// table. Both are updated incrementally by makeMove().
+extern thread_local constinit uint8_t pieceCount[12];
+extern thread_local constinit uint64_t material_key;
 
 
 
@@ -155,8 +177,23 @@ enum castling { wk = 1, wq = 2, bk = 4, bq = 8 };
 //
 // repetition_table stores a number of positions "played" during the search
 // repetition_index tells the size of the repetition_table (pointer to last)
-extern Bitboard repetition_table[1024];
-extern int repetition_index;
+extern thread_local constinit Bitboard repetition_table[1024];
+extern thread_local constinit int repetition_index;
+
+
+
+// Cuckoo tables to detect upcoming repetitions (@see hasUpcomingRepetition()):
+//
+// cuckoo stores the keys of all the reversible moves (i.e., the Zobrist
+// difference between the positions before and after the move), and
+// cuckooMove stores the from and to squares of each move. Every key is in one
+// of 2 possible slots, given by the hash functions CuckooH1 and CuckooH2.
+#define CuckooSize         8192
+#define CuckooH1(key)      ((key) & (CuckooSize - 1))
+#define CuckooH2(key)      (((key) >> 16) & (CuckooSize - 1))
+
+extern uint64_t cuckoo[CuckooSize];
+extern uint16_t cuckooMove[CuckooSize];
 
 
 
@@ -164,25 +201,54 @@ extern int repetition_index;
 // resting the board to its initial status, printing the board and
 // parsing positions in FEN notation.
 void resetBoard();
+void initCuckoo();
 void printBoard();
 void setPosition(const std::string &);
 std::string getFEN();
 
 
 
+// pieceOn
+//
+// Return the piece on the given (occupied) square.
+static inline int pieceOn(int square)
+{
+    // reliability checks
+    assert(occupancies[Both] & SqBB[square]);
+
+
+    // look only into the bitboards of the side owning the square
+    int piece = (occupancies[White] & SqBB[square]) ? P : p;
+
+    while (!(bitboards[piece] & SqBB[square]))
+        piece++;
+
+
+    return piece;
+}
+
+
+
 // isRepetition
 //
-// Counts the 3-fold repetitions played on the board. Returns the number
-// of repetitions, i.e., a return value >= 3 means it's a draw.
+// Check whether the current position has already been played on the board.
+//
+// repetition_table[repetition_index] holds the position 1 ply ago, so the
+// position i plies ago is at repetition_index - i + 1. Only the positions
+// since the last irreversible move (the last fifty plies) with the same side
+// to move (every other ply) can be the same as the current one.
 static inline int isRepetition()
 {
     // reliability checks
     assert(ply > 0);
 
 
-    // if we found the hash key same with a current
-    for (int index = repetition_index; index > 0; index--)
-        if (repetition_table[index] == hash_key)
+    // scan the reversible plies only (not beyond a null move), with the
+    // same side to move
+    int end = std::min({ fifty, pliesFromNull, repetition_index });
+
+    for (int i = 2; i <= end; i += 2)
+        if (repetition_table[repetition_index - i + 1] == hash_key)
             return true;
    
 
@@ -191,6 +257,53 @@ static inline int isRepetition()
 
 
 
+// hasUpcomingRepetition
+//
+// Check whether the side to move can play a (reversible) move that goes back
+// to a position already played during the search, i.e., whether it can force
+// a draw by repetition right away. This is Marcel van Kervinck's algorithm,
+// as implemented in Stockfish: the Zobrist difference between the current
+// position and a previous one (with the other side to move) is looked up in
+// the cuckoo tables of reversible moves; if found, the move is playable when
+// the squares between its from and to squares are empty.
+//
+// @see http://web.archive.org/web/20201107002606/https://marcelk.net/2013-04-06/paper/upcoming-rep-v2.pdf
+static inline bool hasUpcomingRepetition()
+{
+    // at least 3 reversible plies (since the last null move) are needed to
+    // go back to a position
+    int end = std::min({ fifty, pliesFromNull, repetition_index });
+
+    if (end < 3)
+        return false;
+
+
+    // scan the previous positions with the other side to move
+    for (int i = 3; i <= end; i += 2)
+    {
+        // only repetitions within the search tree are considered
+        if (ply <= i)
+            break;
+
+        uint64_t move_key = hash_key ^ repetition_table[repetition_index - i + 1];
+        int slot = CuckooH1(move_key);
+
+        if ((cuckoo[slot] != move_key) && (cuckoo[slot = CuckooH2(move_key)] != move_key))
+            continue;
+
+        int fromSq = cuckooMove[slot] & 0x3f;
+        int toSq   = cuckooMove[slot] >> 6;
+
+        if (!(getSquaresBetween(fromSq, toSq) & occupancies[Both]))
+            return true;
+    }
+
+
+    return false;
+}
+
+
+
 // isDraw
 //
 // Check if the current position is a draw given the following conditions:
@@ -203,6 +316,10 @@ static inline int isRepetition()
 // 3.4 Kminor-Kminor ending 
 // 3.5 KB-KB ending (all bishops on same-color squares)
 // 3.6 KBN-Kminor
+//
+// The draws due to insufficient material depend on the material on the board
+// (and, in one case, on the colors of the bishops), so they are looked up in
+// the material table (@see computeMaterial()).
 static inline bool isDraw()
 {
     // 50-move rule
@@ -215,83 +332,14 @@ static inline bool isDraw()
         return true;
 
 
-    // calculate the number of pieces on the board
-    int total_pieces  = countBits(occupancies[Both]);
-    int white_knights = countBits(bitboards[N]);
-    int black_knights = countBits(bitboards[n]);
-    int white_bishops = countBits(bitboards[B]);
-    int black_bishops = countBits(bitboards[b]);
+    // insufficient material
+    const MaterialEntry_t *material = probeMaterial(material_key);
 
-    
-    // K-K ending
-    if (total_pieces == 2)
-        return true;
+    if (material->draw == MaterialDrawUnlessBishopPair)
+        return ((bitboards[B] & LightSquares) == bitboards[B]) ||
+               ((bitboards[B] & DarkSquares)  == bitboards[B]);
 
-
-    // Kminor-K ending
-    if (total_pieces == 3)
-        if (white_knights || black_knights || white_bishops || black_bishops)
-            return true;
-
-
-    // KNN-K ending
-    if (total_pieces == 4)
-    {
-        if (white_knights == 2)
-            return true;
-
-        else if (black_knights == 2)
-            return true;
-
-        // Kminor-Kminor ending
-        else if ((white_knights || white_bishops) &&
-                 (black_knights || black_bishops))
-        {
-            return true;
-        }
-    }
-
-
-    // KB-KB ending (all bishops on same-color squares)
-    if (((bitboards[B] | bitboards[b]) & LightSquares) ||
-        ((bitboards[B] | bitboards[b]) & DarkSquares))
-    {
-        if ((bitboards[N] | bitboards[R] | bitboards[Q] | bitboards[P] |
-             bitboards[n] | bitboards[r] | bitboards[q] | bitboards[p]) == 0)
-        {
-            return true;
-        }
-    }
-
-
-    // Kminorminor-Kminor ending
-    if ((total_pieces == 5) &&
-        ((white_bishops + white_knights + black_bishops + black_knights) == 3))
-    {
-        // Strong bishop pair vs. Knight is not a draw
-        if (white_bishops == 2)
-        {
-            if (((bitboards[B] & LightSquares) != bitboards[B]) &&
-                (((bitboards[B] & DarkSquares) != bitboards[B])))
-            return false;
-        }
-
-        if (black_bishops == 2)
-        {
-            if (((bitboards[b] & LightSquares) != bitboards[b]) &&
-                (((bitboards[b] & DarkSquares) != bitboards[b])))
-            return false;
-        }
-
-
-        // any other Kminor+minor vs. Kminor combination
-        else
-            return true;
-    }
-
-
-    // in any other case, it is not a draw
-    return false;
+    return material->draw == MaterialDraw;
 }
 
 
@@ -301,7 +349,7 @@ static inline bool isDraw()
 // Return true if there are no major nor minor pieces left on the board.
 static inline bool noMajorsOrMinors()
 {
-    return !(countBits(occupancies[Both]) - countBits(bitboards[P]) - countBits(bitboards[p]) - 2);
+    return probeMaterial(material_key)->noPieces;
 }
 
 
@@ -22,9 +22,19 @@
 #include <iomanip>
 #include <chrono>
 #include <cassert>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <thread>
+#include <future>
+#include <atomic>
 
 #include "search.h"
 #include "eval.h"
+#include "tb.h"
+#include "tbprobe.h"
+#include "stats.h"
+#include "trace.h"
 
 
 
@@ -35,14 +45,24 @@ uint64_t nodes = 0ULL;
 
 
 
+// Maximum no. of nodes of the current search
+uint64_t maxNodes = MaxSearchNodes;
+
+
+
+// Nodes left on the clock (nodestime)
+int64_t availableNodes = 0;
+
+
+
 // Limits holds the configuration of the search: time, search depth, etc.
 Limits_t Limits;
 
 
 
-// Options holds more settings (aside from Limits) that can set via the
-// setoption command in UCI.
-std::map<string, int> Options;
+// SearchOptions holds the settings (aside from Limits) that can be set via the
+// setoption command in UCI, as of the start of the search.
+SearchOptions_t SearchOptions = { OptionsDefaultContempt, 0, false };
 
 
 
@@ -63,12 +83,44 @@ bool     timeset   = true;
 // beta cut-offs, where a move killer moves [id][ply]
 //
 // Note: storing exactly 2 killer moves is best for efficiency/performance.
-int killers[2][MaxPly];
+Move killers[2][MaxPly];
+
+
+
+// butterfly history [side][from][to]
+int16_t history[2][64][64];
+
+
+
+// countermoves [piece][square]
+Move counterMoves[12][64];
+
 
 
+// continuation history [piece][square][piece][square]
+int16_t continuationHistory[12][64][12][64];
 
-// history heuristics [piece][square]
-int history[12][64];
+
+
+// current move [ply]
+PlyMove_t currentMove[MaxPly];
+
+
+
+// static evaluation [ply]
+//
+// Static evaluation of the positions along the current line, used for telling
+// whether the side to move is improving its position since its previous move.
+// Positions in check are not evaluated, and hold -ValueInfinite.
+int staticEvals[MaxPly];
+
+
+
+// late move reductions [depth][move number]
+//
+// Base reduction of the late moves, growing with the logarithm of both the
+// depth and the number of legal moves tried so far. @see initSearch()
+int LMRReductions[LMRTableSize][LMRTableSize];
 
 
 
@@ -78,7 +130,7 @@ int pv_length[MaxPly];
 
 
 // PV table [ply][ply]
-int pv_table[MaxPly][MaxPly];
+Move pv_table[MaxPly][MaxPly];
 
 
 
@@ -97,6 +149,28 @@ bool allowNull = true;
 std::array<int, 4> LateMovePruningMargins = { 0, 8, 12, 24};
 constexpr int RFPMargin = 64;
 constexpr int RazorMargin = 339;
+constexpr int SEEPruningDepth = 8;
+constexpr int SEECaptureMargin = -19;
+constexpr int SEEQuietMargin = -64;
+
+
+
+// Late move reductions' parameters: the base reduction is
+// LMRBase + log(depth) * log(moves) / LMRDivisor, and quiet moves are reduced
+// one ply less (or more) for every LMRHistoryDivisor points of history score
+constexpr double LMRBase = 0.75;
+constexpr double LMRDivisor = 2.25;
+constexpr int LMRHistoryDivisor = 8192;
+
+
+
+// Bonus (or malus) of the history tables for a move searched at a given depth
+constexpr int HistoryBonusFactor = 32;
+
+
+
+// Maximum no. of quiet moves searched in a node whose history gets a malus
+constexpr int MaxQuietsSearched = 64;
 
 
 
@@ -114,6 +188,82 @@ std::array<int, 13> PieceValues = { 100, 300, 300, 500, 900, ValueInfinite,
 void initSearch()
 {
     resetLimits();
+
+
+    // precompute the base late move reductions
+    for (int depth = 1; depth < LMRTableSize; depth++)
+        for (int moves = 1; moves < LMRTableSize; moves++)
+            LMRReductions[depth][moves] = int(LMRBase + log(depth) * log(moves) / LMRDivisor);
+}
+
+
+
+// updateHistory
+//
+// Add a bonus (or a malus, if negative) to an entry of the history tables.
+// The change is scaled down as the entry gets closer to HistoryMax (gravity),
+// so that entries saturate instead of overflowing, and the scores of moves
+// that stop producing cut-offs fade away.
+static inline void updateHistory(int16_t &entry, int bonus)
+{
+    entry += bonus - entry * std::abs(bonus) / HistoryMax;
+}
+
+
+
+// updateQuietHistories
+//
+// Update the butterfly and continuation history of a quiet move in the
+// current position (before the move is made).
+static inline void updateQuietHistories(Move move, int bonus)
+{
+    int piece = getMovePiece(move);
+    int toSq  = getMoveTarget(move);
+
+    updateHistory(history[sideToMove][getMoveSource(move)][toSq], bonus);
+
+
+    // there is no continuation after the root or a null move
+    for (int i = 1; (i <= 2) && (i <= ply); i++)
+    {
+        const PlyMove_t &prev = currentMove[ply - i];
+
+        if (prev.move)
+            updateHistory(continuationHistory[prev.piece][getMoveTarget(prev.move)][piece][toSq], bonus);
+    }
+}
+
+
+
+// updateQuietStats
+//
+// Update the move ordering tables after a quiet move produced a beta cut-off:
+// store it as a killer and as the countermove of the previous move, and give
+// it a history bonus, as well as a malus to the quiet moves searched before
+// it, which failed to produce the cut-off.
+static void updateQuietStats(Move bestmove, Move *quiets, int quietCount, int depth)
+{
+    int bonus = std::min(HistoryBonusFactor * depth * depth, HistoryBonusMax);
+
+
+    // store killer moves
+    if (killers[0][ply] != bestmove)
+    {
+        killers[1][ply] = killers[0][ply];
+        killers[0][ply] = bestmove;
+    }
+
+
+    // store the countermove (no previous move at the root or after a null move)
+    if (ply && currentMove[ply - 1].move)
+        counterMoves[currentMove[ply - 1].piece][getMoveTarget(currentMove[ply - 1].move)] = bestmove;
+
+
+    // history bonus and malus
+    updateQuietHistories(bestmove, bonus);
+
+    for (int i = 0; i < quietCount; i++)
+        updateQuietHistories(quiets[i], -bonus);
 }
 
 
@@ -145,10 +295,23 @@ void resetLimits()
 // Main alphabeta algorithm (Negamax) which relies on a Principal Variation
 // search.
 //
+// The type of node (Root, PV or NonPV) is known at every call site, so it is
+// a template parameter: the root-only and PV-only logic is resolved at
+// compile time, and NonPV nodes (searched with a null window, most of the
+// nodes of the tree) get their own, tighter code.
+template <NodeType Node>
 int negamax(int alpha, int beta, int depth)
 {
+    // node type and type of the first child node
+    constexpr bool RootNode = (Node == Root);
+    constexpr bool PvNode   = (Node != NonPV);
+    constexpr NodeType FirstChild = PvNode ? PV : NonPV;
+
+
     // reliability checks
     assert(depth >= 0);
+    assert(RootNode == (ply == 0));
+    assert(PvNode || (alpha == beta - 1));
 
 
     // variables holding the calculatd score from negamax(), static evaluation
@@ -157,26 +320,38 @@ int negamax(int alpha, int beta, int depth)
 
 
     // best move (to use with the transposition table)
-    int bestmove = 0;
+    Move bestmove = 0;
 
 
     // if the position is a draw, don't search anymore
-    if (ply && isDraw())
+    if (!RootNode && isDraw())
         return contempt();
 
 
-    // initialize hash flag for the transposition table
-    int hash_type = hash_type_alpha;
+    // if the side to move can go back to a previous position (a draw by
+    // repetition), the draw score is a lower bound of the score
+    if (!RootNode && (alpha < contempt()) && hasUpcomingRepetition())
+    {
+        alpha = contempt();
+
+        if (alpha >= beta)
+            return alpha;
+    }
 
 
-    // figure out whether the current node is PV node or not
-    bool pv_node = ((beta - alpha) > 1);
+    // initialize hash flag for the transposition table
+    int hash_type = hash_type_alpha;
 
 
     // flag to detect whether we can prune futile moves
     bool canFutilityPrune = false;
 
 
+    // whether the static evaluation is better than 2 plies ago, i.e., before
+    // our previous move (late moves are reduced less when improving)
+    bool improving = false;
+
+
 
     ///////////////////////////////////////////////////////////////////////////
     //
@@ -211,9 +386,12 @@ int negamax(int alpha, int beta, int depth)
     //
     // @see https://www.chessprogramming.org/Transposition_Table
 
-    if (ply && ((score = TT::probe(alpha, beta, bestmove, depth)) != no_hash_found) && !pv_node)
+    if (!RootNode && ((score = TT::probe(alpha, beta, bestmove, depth)) != no_hash_found) && !PvNode)
         if (fifty < 90)
+        {
+            STAT(ttCutoffs);
             return score;
+        }
 
 
 
@@ -221,18 +399,25 @@ int negamax(int alpha, int beta, int depth)
     //
     // Step 3. Tablebases probe
     //
-    // If we have five (5) pieces left, including the kings, try to find the 
-    // position from the tablebases (syzygy), so no more search is needed.
+    // If there are few enough pieces left on the board, and the position
+    // can be found in the tablebases (syzygy), no more search is needed. We
+    // only probe right after a capture or pawn move (fifty == 0), since the
+    // WDL tables don't know about the 50-move rule counter.
+    //
+    // @see https://www.chessprogramming.org/Syzygy_Bases
 
-    if (ply && (countBits(occupancies[Both]) <= 5) && (fifty == 0) && !castle)
+    if (!RootNode && (fifty == 0) && TB::canProbe())
     {
-        /*
-        int wdl_score = TB::wdl_probe();
+        unsigned wdl = TB::probeWDL();
+
+        if (wdl != TB_RESULT_FAILED)
+        {
+            tbhits++;
 
-        return (wdl_score < -DrawScore ? MateValue + ply + 1
-              : wdl_score >  DrawScore ? MateValue - ply - 1
-              : DrawScore);
-        */
+            return (wdl == TB_WIN)  ?  TBWinScore - ply
+                 : (wdl == TB_LOSS) ? -TBWinScore + ply
+                 : DrawScore;
+        }
     }
 
 
@@ -250,7 +435,10 @@ int negamax(int alpha, int beta, int depth)
     // number of legal moves found
     int legal = 0;
 
-    // increment nodes count
+    // stop exactly at the node limit, if any, or increment nodes count
+    if (nodeLimitReached())
+        return 0;
+
     nodes++;
 
     // is king in check? --> needed for detecting mate and in-check extension
@@ -276,6 +464,7 @@ int negamax(int alpha, int beta, int depth)
     if (inCheck)
     {
         depth++;
+        staticEvals[ply] = -ValueInfinite;
         goto moves_loop;
     }
 
@@ -292,7 +481,7 @@ int negamax(int alpha, int beta, int depth)
     // @see https://www.chessprogramming.org/Quiescence_Search
 
     if (depth == 0)
-        return qsearch(alpha, beta);
+        return qsearch<FirstChild>(alpha, beta);
 
 
 
@@ -307,6 +496,10 @@ int negamax(int alpha, int beta, int depth)
     // we can fail low or high immediately without ending in the full search.
 
     StaticEval = evaluate();
+    STAT(evals);
+
+    staticEvals[ply] = StaticEval;
+    improving = (ply < 2) || (StaticEval > staticEvals[ply - 2]);
 
 
 
@@ -319,11 +512,12 @@ int negamax(int alpha, int beta, int depth)
     //
     // @see https://www.chessprogramming.org/Razoring
 
-    if (ply && !pv_node
+    if (!PvNode
             && (depth < 2)
             && ((StaticEval + RazorMargin) <= alpha))
     {
-        return qsearch(alpha, beta);
+        STAT(razorPrunes);
+        return qsearch<NonPV>(alpha, beta);
     }
 
     
@@ -340,11 +534,14 @@ int negamax(int alpha, int beta, int depth)
     //
     // @see https://www.chessprogramming.org/Reverse_Futility_Pruning
 
-    if (!pv_node)
+    if (!PvNode)
     {
         EvalMargin = depth * RFPMargin;
         if ((depth < 9) && (StaticEval - EvalMargin) >= beta)
-                return (StaticEval - EvalMargin);
+        {
+            STAT(rfpPrunes);
+            return (StaticEval - EvalMargin);
+        }
     }
 
 
@@ -361,7 +558,7 @@ int negamax(int alpha, int beta, int depth)
     //
     // @see https://www.chessprogramming.org/Null_Move_Pruning
 
-    if (!pv_node && allowNull && (depth >= 3) && !noMajorsOrMinors())
+    if (!PvNode && allowNull && (depth >= 3) && !noMajorsOrMinors())
     {
         // R: is the reduction factor. The larger the R, the shallower the
         //    search is and the faster (but likely less reliable) the pruning
@@ -372,8 +569,13 @@ int negamax(int alpha, int beta, int depth)
         // @see https://github.com/algerbrex/blunder/blob/main/engine/search.go
         int R = 3 + depth/6;
 
+        STAT(nullTries);
+
         // preserve board state
         saveBoard();
+
+        // record the null move, which the next moves can't continue from
+        currentMove[ply].move = 0;
         
         // increment ply
         ply++;
@@ -381,6 +583,9 @@ int negamax(int alpha, int beta, int depth)
         // increment repetition index & store hash key
         repetition_index++;
         repetition_table[repetition_index] = hash_key;
+
+        // no position before the null move can be repeated after it
+        pliesFromNull = 0;
         
         // hash enpassant if available
         if (epsq != NoSq)
@@ -399,7 +604,7 @@ int negamax(int alpha, int beta, int depth)
         allowNull = false;
                 
         // search moves with reduced depth to find beta cutoffs
-        score = -negamax(-beta, -beta + 1, depth - R - 1);
+        score = -negamax<NonPV>(-beta, -beta + 1, std::max(depth - R - 1, 0));
 
         // restore allowNull
         allowNull = true;
@@ -418,7 +623,10 @@ int negamax(int alpha, int beta, int depth)
 
         // fail-hard beta cutoff
         if (score >= beta)
+        {
+            STAT(nullCutoffs);
             return beta;
+        }
     }
 
 
@@ -435,7 +643,7 @@ int negamax(int alpha, int beta, int depth)
     //
     // @see https://www.chessprogramming.org/Futility_Pruning
 
-    if (ply && !pv_node && (depth <= 8))
+    if (!PvNode && (depth <= 8))
         if ((StaticEval + futility_margin(depth)) <= alpha)
 			canFutilityPrune = true;
 
@@ -446,7 +654,7 @@ int negamax(int alpha, int beta, int depth)
     // Step 10. No-hashmove reduction (taken from Stockfish)
     //
     // If the position is not in TT, decrease depth by 1 (~3 Elo)
-    if (pv_node && (depth >= 3) && !bestmove)
+    if (PvNode && (depth >= 3) && !bestmove)
         depth--;
 
 
@@ -457,9 +665,14 @@ int negamax(int alpha, int beta, int depth)
  
         
     
-    // create a new move list and generate the moves
+    // create a new move list and generate the moves (only the evasions, if
+    // in check)
     MoveList_t MoveList;
-    generateMoves(MoveList);
+
+    if (inCheck)
+        generateEvasions(MoveList);
+    else
+        generateMoves(MoveList);
 
 
     // if we are following PV line, enable PV move scoring
@@ -474,6 +687,17 @@ int negamax(int alpha, int beta, int depth)
     // number of moves searched so far, within a move list
     int moves_searched = 0;
 
+
+    // quiet moves searched so far, for penalizing their history on a cutoff
+    Move quietsSearched[MaxQuietsSearched];
+    int quietCount = 0;
+
+
+    // check squares, discovered check candidates and pinned pieces, to
+    // tell whether each move gives check (or is legal) before making it
+    CheckInfo_t ci;
+    setCheckInfo(ci);
+
    
 
     ///////////////////////////////////////////////////////////////////////////
@@ -485,59 +709,39 @@ int negamax(int alpha, int beta, int depth)
 
     for (int count = 0; count < MoveList.count; count++)
     {
-        // preserve board state
-        saveBoard();
-       
-
-        // increment ply
-        ply++;
-
-
-        // increment repetition index & store hash key
-        repetition_index++;
-        repetition_table[repetition_index] = hash_key;
-       
-
-        // make the move and check if it is illegal - skip it if so
-        if (!makeMove(MoveList.moves[count]))
+        // skip illegal moves: outside of check, they are detected without
+        // making them (evasions are verified by makeMove() below)
+        if (!inCheck)
         {
-            // in case of illegal move, undo it and skip to the next one
-            repetition_index--;
-            ply--;
-            takeBack();
-            
-            continue;
+            if (!isLegal(MoveList.moves[count].move, ci))
+                continue;
+
+            legal++;
         }
 
 
         // used for avoiding reductions on moves that give check
-        bool givesCheck = isSquareAttacked((sideToMove == White) ? ls1b(bitboards[K]) : 
-                                                                   ls1b(bitboards[k]),
-                                                                   sideToMove ^ 1);
+        bool givesCheck = ::givesCheck(MoveList.moves[count].move, ci);
 
 
-        // increment legal moves
-        legal++;
+        // captures are told from the board, so before the move is made
+        bool capture = getMoveCapture(MoveList.moves[count].move);
 
 
+        // killers and the history score of quiet moves, for pruning and
+        // reducing them (the moving piece is also told from the board)
+        bool killer = (killers[0][ply] == MoveList.moves[count].move)
+                   || (killers[1][ply] == MoveList.moves[count].move);
 
-        ////////////////////////////////////////////////////////////////////////
-        //
-        // Step 12. Full-width and full-depth search
-        //
-        // If this is the first move we are searching, we run a full search to
-        // obtain a score that will guide the next searches.
-
-        if (moves_searched == 0)
-            score = -negamax(-beta, -alpha, depth - 1);
+        int moveHistory = capture ? 0 : quietHistory(MoveList.moves[count].move);
 
 
 
-        else
+        if (moves_searched > 0)
         {
             ////////////////////////////////////////////////////////////////////////
             // 
-            // Step 13. Futility Pruning on current move
+            // Step 12. Futility Pruning on current move
             // 
             // If we're close to the horizon, and even with a large margin the static
             // evaluation can't be raised above alpha, we're probably in a fail-low
@@ -545,23 +749,20 @@ int negamax(int alpha, int beta, int depth)
             // don't waste time searching moves that suck and probably don't even have
             // a chance of raising alpha.
             //
+            // The move is pruned before it is made.
+            //
             // @see https://www.chessprogramming.org/Futility_Pruning
 
             if (canFutilityPrune && (legal > 1))
             {
-                if (!givesCheck && (killers[0][ply] != MoveList.moves[count])
-                                && (killers[1][ply] != MoveList.moves[count])
-                                && (getMovePiece(MoveList.moves[count]) != P)
-                                && (getMovePiece(MoveList.moves[count]) != p)
-                                && !getPromo(MoveList.moves[count])
-                                && !getCastle(MoveList.moves[count])
-                                && !getMoveCapture(MoveList.moves[count]))
+                if (!givesCheck && !killer
+                                && (getMovePiece(MoveList.moves[count].move) != P)
+                                && (getMovePiece(MoveList.moves[count].move) != p)
+                                && !getPromo(MoveList.moves[count].move)
+                                && !getCastle(MoveList.moves[count].move)
+                                && !capture)
                 {
-                    // undo the current move and skip to the next one
-                    repetition_index--;
-                    ply--;
-                    takeBack();
-
+                    STAT(futilityPrunes);
                     continue;
                 }
             }
@@ -570,7 +771,7 @@ int negamax(int alpha, int beta, int depth)
 
             ////////////////////////////////////////////////////////////////////////
             // 
-            // Step 14: Late Move Pruning (LMP)
+            // Step 13: Late Move Pruning (LMP)
             //
             // Because of move ordering, moves late in the move list are not very
             // likely to be interesting, so save time by completing pruning such
@@ -578,25 +779,97 @@ int negamax(int alpha, int beta, int depth)
             // miss a tactical move however, so the further away we prune from
             // the horizon, the "later" the move needs to be.
 
-		    if (ply && !pv_node
+		    if (!PvNode
                     && (depth <= 3)
                     && !inCheck
-                    && !getMoveCapture(MoveList.moves[count])
+                    && !capture
                     && (legal > LateMovePruningMargins[depth]))
             {
-                // undo the current move and skip to the next one
-                repetition_index--;
-                ply--;
-                takeBack();
-
+                STAT(lmpPrunes);
                 continue;
 			}
 
 
 
+            ////////////////////////////////////////////////////////////////////////
+            // 
+            // Step 14: Static Exchange Evaluation (SEE) pruning
+            //
+            // Close to the horizon, skip the moves that lose material in the
+            // exchange on their target square: captures losing more than a margin
+            // growing quadratically with depth, and quiet moves that put a piece
+            // en prise beyond a margin growing linearly with depth.
+            //
+            // @see https://www.chessprogramming.org/Static_Exchange_Evaluation
+
+            if (!PvNode
+                    && (depth <= SEEPruningDepth)
+                    && !inCheck
+                    && !givesCheck
+                    && !seeGE(MoveList.moves[count].move, capture ? SEECaptureMargin * depth * depth
+                                                                  : SEEQuietMargin * depth))
+            {
+                STAT(seePrunes);
+                continue;
+            }
+        }
+
+
+
+        // preserve board state
+        saveBoard();
+
+
+        // record the move for the countermoves and continuation history
+        currentMove[ply].move  = MoveList.moves[count].move;
+        currentMove[ply].piece = getMovePiece(MoveList.moves[count].move);
+       
+
+        // increment ply
+        ply++;
+
+
+        // increment repetition index & store hash key
+        repetition_index++;
+        repetition_table[repetition_index] = hash_key;
+       
+
+        // make the move and check if it is illegal (only possible when in
+        // check) - skip it if so
+        if (!makeMove(MoveList.moves[count].move))
+        {
+            // in case of illegal move, undo it and skip to the next one
+            repetition_index--;
+            ply--;
+            takeBack();
+            
+            continue;
+        }
+
+
+        // increment legal moves (in check, once the move is known to be legal)
+        if (inCheck)
+            legal++;
+
+
+
+        ////////////////////////////////////////////////////////////////////////
+        //
+        // Step 15. Full-width and full-depth search
+        //
+        // If this is the first move we are searching, we run a full search to
+        // obtain a score that will guide the next searches.
+
+        if (moves_searched == 0)
+            score = -negamax<FirstChild>(-beta, -alpha, depth - 1);
+
+
+
+        else
+        {
             ////////////////////////////////////////////////////////////////////
             //
-            // Step 15. Late move reductions (LMR)
+            // Step 16. Late move reductions (LMR)
             //
             // Assuming that the moves in the list are ordered from potential
             // best to potential worst, analyzing the first moves is more
@@ -604,13 +877,40 @@ int negamax(int alpha, int beta, int depth)
             // first 3 moves in full-depth, but cut down the analysis depth for
             // the rest of moves.
             //
+            // The reduction grows with the depth and the move number (@see
+            // LMRReductions), and is then adjusted to the node and the move:
+            // we reduce less in PV nodes, for killers and moves with a good
+            // history, and more when our position is not improving.
+            //
             // @see https://www.chessprogramming.org/Late_Move_Reductions
 
-            if (ply && (legal >= LMRFullDepthMoves)
+            int R = 0;
+
+            if ((legal >= LMRFullDepthMoves)
                     && (depth >= LMRReductionLimit)
                     && !inCheck
-                    && !getMoveCapture(MoveList.moves[count]))
-                score = -negamax(-alpha - 1, -alpha, depth - 2);
+                    && !capture)
+            {
+                R = LMRReductions[std::min(depth, LMRTableSize - 1)]
+                                 [std::min(legal, LMRTableSize - 1)];
+
+                R -= PvNode;
+                R += !improving;
+                R -= killer;
+                R -= moveHistory / LMRHistoryDivisor;
+
+                // never drop into qsearch from here
+                R = std::clamp(R, 0, depth - 2);
+            }
+
+            if (R > 0)
+            {
+                STAT(lmrReductions);
+                score = -negamax<NonPV>(-alpha - 1, -alpha, depth - 1 - R);
+
+                if (score > alpha)
+                    STAT(lmrResearches);
+            }
 
             
             // hack to ensure that full-depth search is done next
@@ -621,7 +921,7 @@ int negamax(int alpha, int beta, int depth)
 
             ////////////////////////////////////////////////////////////////////
             //
-            // Step 16. Principal Variation search (PVS)
+            // Step 17. Principal Variation search (PVS)
             //
             // Once you've found a move with a score that is between alpha and
             // beta, the rest of the moves are searched with the goal of proving
@@ -630,7 +930,7 @@ int negamax(int alpha, int beta, int depth)
 
             if (score > alpha)
             {
-                score = -negamax(-alpha - 1, -alpha, depth - 1);
+                score = -negamax<NonPV>(-alpha - 1, -alpha, depth - 1);
         
 
                 // If the algorithm finds out that it was wrong, and that one of
@@ -638,9 +938,10 @@ int negamax(int alpha, int beta, int depth)
                 // has to search again, in the normal alpha-beta manner. This
                 // happens sometimes, and it's a waste of time, but generally
                 // not often enough to counteract the savings gained from doing
-                // the "bad move proof" search referred to earlier.
-                if ((score > alpha) && (score < beta))
-                    score = -negamax(-beta, -alpha, depth - 1);
+                // the "bad move proof" search referred to earlier. In NonPV
+                // nodes, the window is already null, so there's no re-search.
+                if (PvNode && (score > alpha) && (score < beta))
+                    score = -negamax<PV>(-beta, -alpha, depth - 1);
             }
         }
 
@@ -672,12 +973,7 @@ int negamax(int alpha, int beta, int depth)
 
 
             // store the best move in the TT
-            bestmove = MoveList.moves[count];
-
-
-            // store history moves (only for quiet moves)
-            if (!getMoveCapture(MoveList.moves[count]))
-                history[getMovePiece(MoveList.moves[count])][getMoveTarget(MoveList.moves[count])] += depth;
+            bestmove = MoveList.moves[count].move;
 
 
             // PV node (move)
@@ -685,7 +981,7 @@ int negamax(int alpha, int beta, int depth)
 
 
             // write PV move
-            pv_table[ply][ply] = MoveList.moves[count];
+            pv_table[ply][ply] = MoveList.moves[count].move;
 
             
             // copy moves from deeper ply into current ply's line
@@ -700,15 +996,25 @@ int negamax(int alpha, int beta, int depth)
             // fail-high (beta cutoff)
             if (score >= beta)
             {
+                STAT(betaCutoffs);
+
+                if (moves_searched == 1)
+                    STAT(firstMoveCutoffs);
+
+
                 // store hash entry with the score equal to beta, only if not null move
                 TT::save(beta, bestmove, depth, hash_type_beta);
                
 
-                // store killer moves (only for quiet moves)
-                if (!getMoveCapture(MoveList.moves[count]))
+                // update killers, countermoves and history (only for quiet moves)
+                if (!capture)
                 {
-                    killers[1][ply] = killers[0][ply];
-                    killers[0][ply] = MoveList.moves[count];
+                    STAT(quietCutoffs);
+
+                    if (quietCount == 0)
+                        STAT(firstQuietCutoffs);
+
+                    updateQuietStats(bestmove, quietsSearched, quietCount, depth);
                 }
 
 
@@ -716,13 +1022,18 @@ int negamax(int alpha, int beta, int depth)
                 return beta;
             }
         }
+
+
+        // keep track of the quiet moves that didn't produce a cutoff
+        if (!capture && (quietCount < MaxQuietsSearched))
+            quietsSearched[quietCount++] = MoveList.moves[count].move;
     }
 
 
 
     ///////////////////////////////////////////////////////////////////////////
     //
-    // Step 17. Check if it's end of game
+    // Step 18. Check if it's end of game
     //
     // If there are no legal moves, it's either checkmate or stalemate.
 
@@ -742,7 +1053,7 @@ int negamax(int alpha, int beta, int depth)
 
     ///////////////////////////////////////////////////////////////////////////
     //
-    // Step 18. Save the best move in the Transposition Table
+    // Step 19. Save the best move in the Transposition Table
     //
     // After finishing the search, we make sure we update the Transposition
     // Table with the best move.
@@ -757,6 +1068,39 @@ int negamax(int alpha, int beta, int depth)
 
 
 
+// firstLegalMove
+//
+// Return the first legal move in the current position, or 0 if there is
+// none. This is the fallback best move of a search that was stopped before
+// the 1st iteration could search any root move (e.g., 'go nodes 1').
+static Move firstLegalMove()
+{
+    MoveList_t MoveList;
+    generateMoves(MoveList);
+
+
+    for (int count = 0; count < MoveList.count; count++)
+    {
+        // preserve board state
+        saveBoard();
+
+
+        // the move is legal if it can be made
+        if (makeMove(MoveList.moves[count].move))
+        {
+            takeBack();
+            return MoveList.moves[count].move;
+        }
+
+        takeBack();
+    }
+
+
+    return 0;
+}
+
+
+
 // search
 //
 // The search is started when the program receives the UCI 'go'
@@ -777,11 +1121,14 @@ void search()
 
     // start the timer as soon as possible
     auto start = chrono::high_resolution_clock::now();
+    uint64_t traceStart = Trace::now();
 
 
     // reset data structures for a new search
     memset(killers, 0, sizeof(killers));
     memset(history, 0, sizeof(history));
+    memset(counterMoves, 0, sizeof(counterMoves));
+    memset(continuationHistory, 0, sizeof(continuationHistory));
     memset(pv_table, 0, sizeof(pv_table));
     memset(pv_length, 0, sizeof(pv_length));
 
@@ -797,8 +1144,16 @@ void search()
     int beta  =  ValueInfinite;
 
 
-    // reset nodes counter
-    nodes = 0ULL;
+    // reset nodes and tablebase hits counters, and the search statistics
+    nodes    = 0ULL;
+    tbhits   = 0ULL;
+    maxNodes = Limits.nodes ? Limits.nodes : MaxSearchNodes;
+
+    Stats::clear();
+
+
+    // entries stored from now on belong to a new search
+    TT::newSearch();
 
 
     // reset "time is up" flag
@@ -818,7 +1173,15 @@ void search()
    
 
         // find best move within a given position
-        score = negamax(alpha, beta, current_depth);
+        uint64_t iterationStart = Trace::now();
+
+        score = negamax<Root>(alpha, beta, current_depth);
+
+
+        // an interrupted iteration has no valid score: the best move is the
+        // one of the last iteration (or a better one found since then)
+        if (timedout)
+            break;
 
 
 
@@ -832,6 +1195,9 @@ void search()
 
         if ((score <= alpha) || (score >= beta))
         {
+            Trace::complete("aspiration fail", iterationStart,
+                            {{"depth", current_depth}, {"score", score}});
+
             alpha = -ValueInfinite;
             beta  =  ValueInfinite;
             current_depth--;
@@ -844,6 +1210,13 @@ void search()
         beta  = score + AspirationWindow;
 
 
+        // keep the statistics and the trace of this iteration
+        Stats::endIteration(current_depth);
+
+        Trace::complete("iteration", iterationStart,
+                        {{"depth", current_depth}, {"score", score}, {"nodes", int64_t(nodes)}});
+
+
         // stop the timer and measure time elapsed
         auto finish = chrono::high_resolution_clock::now();
         auto ms = chrono::duration_cast<chrono::milliseconds>(finish-start).count();
@@ -867,6 +1240,7 @@ void search()
             cout << " nodes " <<  nodes
                  << " nps " << nodes * 1000000000 / ns
                  << " hashfull " << TT::hashfull()
+                 << " tbhits " << tbhits
                  << " time " << ms
                  << " pv ";
             
@@ -877,16 +1251,32 @@ void search()
 
             // new line before next depth
             cout << endl << flush;
+
+            Trace::instant("info", {{"depth", current_depth}});
         }
     }
 
 
-    // print bestmove
+    // a search stopped by the node limit during the 1st iteration may not
+    // have any root move yet: never return a null move
+    if (!pv_table[0][0])
+        pv_table[0][0] = firstLegalMove();
+
+
+    // print the search statistics, if enabled, and the bestmove
+    Stats::printSummary();
     cout << "bestmove " << prettyMove(pv_table[0][0]) << endl << flush;
 
+    Trace::instant("bestmove", {{"move", pv_table[0][0]}});
+    Trace::complete("search", traceStart, {{"nodes", int64_t(nodes)}});
+
 
     // tell the engine that the search is ready
     timedout = true;
+
+
+    // write the trace of this search, now that the timing doesn't matter
+    Trace::flush();
 }
 
 
@@ -899,14 +1289,26 @@ void search()
 // a) no more possible captures
 // b) no more pawn promotions
 // c) depth is too deep or time (from a running timer) is up
+//
+// Like negamax(), qsearch() is specialized for PV and NonPV nodes.
+template <NodeType Node>
 int qsearch(int alpha, int beta)
 {
+    // reliability checks
+    static_assert(Node != Root);
+    assert((Node == PV) || (alpha == beta - 1));
+
+
     // start searching a score from the beginning (= -ValueInfinite)
     int val, score;
 
 
-    // increment nodes count
+    // stop exactly at the node limit, if any, or increment nodes count
+    if (nodeLimitReached())
+        return 0;
+
     nodes++;
+    STAT(qnodes);
 
 
     // we are too deep, hence there's an overflow of arrays relying on max ply constant
@@ -914,32 +1316,57 @@ int qsearch(int alpha, int beta)
         return evaluate();
 
 
+    // capture sequences transpose a lot: look up the position in the TT, for
+    // a cutoff (only in NonPV nodes) or, at least, a best capture to search
+    // first
+    Move bestmove = 0;
+
+    if (((score = TT::probe<true>(alpha, beta, bestmove, 0)) != no_hash_found) && (Node == NonPV))
+        if (fifty < 90)
+        {
+            STAT(qsTTCutoffs);
+            return score;
+        }
+
+
     // calculate "stand-pat" to stabilize the qsearch
     val = evaluate();
+    STAT(evals);
 
 
     // beta-cutoff
     if (val >= beta)
+    {
+        TT::save(beta, 0, 0, hash_type_beta);
         return beta;
+    }
 
     
     // found a better move (PV node position)
+    int hash_type = hash_type_alpha;
+
     if (val > alpha)
+    {
+        hash_type = hash_type_exact;
         alpha = val;
+    }
    
 
     // generate a new move list and sort it
     MoveList_t MoveList;
     generateCapturesAndPromotions(MoveList);
-    sortMoves(MoveList, 0);
+    sortMoves(MoveList, bestmove);
 
     
     // loop over moves within a movelist
     for (int count = 0; count < MoveList.count; count++)
     {
         // don't search capture sequences that end up in losing material
-        if (see(MoveList.moves[count]) < 0)
+        if (!seeGE(MoveList.moves[count].move, 0))
+        {
+            STAT(seePrunes);
             continue;
+        }
 
 
         // preserve board state
@@ -956,7 +1383,7 @@ int qsearch(int alpha, int beta)
 
         
         // make sure to make only legal moves
-        if (!makeMove(MoveList.moves[count]))
+        if (!makeMove(MoveList.moves[count].move))
         {
             // in case of illegal move, undo it and skip to the next one
             repetition_index--;
@@ -968,7 +1395,7 @@ int qsearch(int alpha, int beta)
 
 
         // score current move
-        score = -qsearch(-beta, -alpha);
+        score = -qsearch<Node>(-beta, -alpha);
        
 
         // undo the move after we got its score
@@ -986,37 +1413,109 @@ int qsearch(int alpha, int beta)
         if (score > alpha)
         {
             // PV node (position)
-            alpha = score;
+            hash_type = hash_type_exact;
+            bestmove  = MoveList.moves[count].move;
+            alpha     = score;
 
 
             // fail-high beta cutoff
             if (score >= beta)
+            {
+                TT::save(beta, bestmove, 0, hash_type_beta);
                 return beta;
+            }
         }
     }
    
 
+    // store the result with depth 0, an exact score or an upper bound
+    TT::save(alpha, bestmove, 0, hash_type);
+
+
     // node (position) fails low
     return alpha;
 }
 
 
 
+// Leaf count reported by countRootMoves() for the illegal root moves
+#define IllegalPerft (~0ULL)
+
+
+
+// countRootMoves
+//
+// Count the leaf nodes under every root move at the given depth, distributing
+// the root moves across the given number of threads: every thread takes the
+// next root move not counted yet, and counts it on its own copy of the
+// position. report(index, leaves) is called from the calling thread in the
+// order of the move list, as soon as each result is available.
+template <bool Hashed, typename Report>
+static void countRootMoves(MoveList_t &MoveList, int depth, int threads, Report report)
+{
+    // keep a copy of the root position for the threads
+    saveBoard();
+
+
+    // one result per root move, collected in order
+    vector<promise<uint64_t>> results(MoveList.count);
+    vector<future<uint64_t>> counts;
+
+    for (promise<uint64_t> &result : results)
+        counts.push_back(result.get_future());
+
+
+    // count the nodes of every root move in parallel
+    atomic<int> next(0);
+
+    auto worker = [&]()
+    {
+        for (int i; (i = next++) < MoveList.count; )
+        {
+            // set up the root position on this thread's board
+            takeBack();
+
+            results[i].set_value(makeMove(MoveList.moves[i].move) ? perft<Hashed>(depth - 1) : IllegalPerft);
+        }
+
+
+        // add this thread's perft table statistics to the totals
+        if (Hashed)
+            PerftTT::collectStats();
+    };
+
+    vector<thread> pool;
+
+    for (int t = 0; t < threads; t++)
+        pool.emplace_back(worker);
+
+
+    // report the results in order
+    for (int move_count = 0; move_count < MoveList.count; move_count++)
+        report(move_count, counts[move_count].get());
+
+    for (thread &t : pool)
+        t.join();
+}
+
+
+
 // dperft
 //
 // Divide-perft is a perft() wrapper that divides a position into each
 // root move and calls perft() for each of them. This is very useful
 // to debug possible errors within the move generator for a given root move.
-void dperft(int depth)
+//
+// The root moves are counted in parallel, on all the hardware threads. If a
+// hash size (in MBytes) is given, the subtrees are cached in a perft table
+// for the duration of the test. In verify mode, every root move is counted
+// again without the table and compared against the hashed count.
+void dperft(int depth, uint32_t hashMB, bool verify)
 {
     // reliability checks
     assert(depth > 0);
 
 
-    // reset nodes count
-    nodes = 0ULL;
-   
-
     // create move list instance
     MoveList_t MoveList;
 
@@ -1024,45 +1523,40 @@ void dperft(int depth)
     // generate moves
     generateMoves(MoveList);
 
-    
-    // init start time
-    auto start = chrono::high_resolution_clock::now();
-   
 
-    // loop over generated moves
-    for (int move_count = 0; move_count < MoveList.count; move_count++)
-    {   
-        // preserve board state
-        saveBoard();
+    // allocate the perft table
+    if (hashMB)
+        PerftTT::init(hashMB);
 
+    bool hashed = (perft_total_entries > 0);
 
-        // make move and, if illegal, skip to the next move
-        if (!makeMove(MoveList.moves[move_count]))
-        {
-            takeBack();
-            continue;
-        }
+    
+    // init start time
+    auto start = chrono::high_resolution_clock::now();
 
 
-        // cummulative nodes
-        uint64_t cNodes = nodes;
+    // count and print every move and the nodes under it, in order
+    int threads = clamp(int(thread::hardware_concurrency()), 1, max(MoveList.count, 1));
+    vector<uint64_t> moveNodes(MoveList.count);
 
+    auto print = [&](int index, uint64_t leaves)
+    {
+        moveNodes[index] = leaves;
 
-        // call perft driver recursively
-        perft(depth - 1);
+        if (leaves == IllegalPerft)
+            return;
 
-        
-        // old nodes
-        uint64_t PrevNodes = nodes - cNodes;
+        nodes += leaves;
 
-        
-        // undo move
-        takeBack();
+        cout << prettyMove(MoveList.moves[index].move) << ": " << leaves << endl;
+    };
 
+    nodes = 0ULL;
 
-        // print move and nodes under that move
-        cout << prettyMove(MoveList.moves[move_count]) << ": " << PrevNodes << endl;
-    }
+    if (hashed)
+        countRootMoves<true>(MoveList, depth, threads, print);
+    else
+        countRootMoves<false>(MoveList, depth, threads, print);
 
 
     // stop the timer and measure time elapsed
@@ -1075,9 +1569,45 @@ void dperft(int depth)
     cout << endl;
     cout << "    Depth: " << depth << endl;
     cout << "    Nodes: " << nodes << endl;
+    cout << "  Threads: " << threads << endl;
     cout << fixed << setprecision(3);
+
+    if (hashed)
+    {
+        uint64_t probes = perft_probes;
+        uint64_t hits   = perft_hits;
+
+        cout << "     Hash: " << hashMB << " MB, " << hits << "/" << probes << " hits ("
+             << (probes ? 100.0 * hits / probes : 0.0) << "%)" << endl;
+    }
+
     cout << "    Time:  " << ns / 1000000.0 << "ms" << endl;
-    cout << "   Speed:  " << nodes * 1000000 / ns << " Knps" << endl << endl;
+    cout << "   Speed:  " << nodes * 1000.0 / ns << " Mnps" << endl << endl;
+    cout << resetiosflags(cout.flags());
+
+
+    // release the perft table
+    PerftTT::free();
+
+
+    // verify mode: count again without the perft table and compare
+    if (verify)
+    {
+        int errors = 0;
+
+        countRootMoves<false>(MoveList, depth, threads, [&](int index, uint64_t leaves)
+        {
+            if (leaves == moveNodes[index])
+                return;
+
+            errors++;
+
+            cout << "Mismatch " << prettyMove(MoveList.moves[index].move) << ": "
+                 << moveNodes[index] << " (expected " << leaves << ")" << endl;
+        });
+
+        cout << "   Verify: " << (errors ? "FAILED" : "OK") << endl << endl;
+    }
 }
 
 
@@ -1094,39 +1624,29 @@ void dperft(int depth)
 //
 // If a "best move" is found in the transposition table, it is placed
 // at the top, making it the first move to be searched.
-void sortMoves(MoveList_t &MoveList, int bestmove)
+void sortMoves(MoveList_t &MoveList, Move bestmove)
 {
     // reliability checks
     assert(MoveList.count > 0);
     assert(MoveList.count < 256);
 
 
-    // associative array linking moves and scores
-    pair<int, int> pairt[256];
-
-
     // find the score for every move
     for (int i = 0; i < MoveList.count; i++) 
     {
         // score bestmove (from TT) above all
-        if (MoveList.moves[i] == bestmove)
-            pairt[i].first = 30000;
+        if (MoveList.moves[i].move == bestmove)
+            MoveList.moves[i].score = 30000;
 
         // rest of moves are scored using scoreMove()
         else
-            pairt[i].first  = scoreMove(MoveList.moves[i]);
-
-        // associate score with the move
-        pairt[i].second = MoveList.moves[i];
+            MoveList.moves[i].score = scoreMove(MoveList.moves[i].move);
     }
   
-    // sort the associative array based on the move score
-    sort(pairt, pairt + MoveList.count, greater<pair<int, int>>());
-     
 
-    // re-write the MoveList ordered by move score in descending order
-    for (int i = 0; i < MoveList.count; i++) 
-        MoveList.moves[i] = pairt[i].second;
+    // sort the moves based on their score
+    sort(MoveList.moves, MoveList.moves + MoveList.count,
+         [](const ScoredMove_t &a, const ScoredMove_t &b) { return a.score > b.score; });
 }
 
 
@@ -1143,8 +1663,8 @@ void printMoveScores(MoveList_t &MoveList)
     for (int count = 0; count < MoveList.count; count++)
     {
         cout << "     move: ";
-        cout << prettyMove(MoveList.moves[count]);
-        cout << " score: " << scoreMove(MoveList.moves[count]) << endl;
+        cout << prettyMove(MoveList.moves[count].move);
+        cout << " score: " << scoreMove(MoveList.moves[count].move) << endl;
     }
     cout << endl << endl;
 }
@@ -1176,7 +1696,7 @@ void resetTimeControl()
 // (static exchange evaluation), and return the final score of the move 
 // (after completing all the captures) from the perspective of the side
 // to move.
-int see(int move)
+int see(Move move)
 {
     // total static evaluation after all possible exchanges have been made
     std::array<int, 32> gain;
@@ -1265,3 +1785,129 @@ int see(int move)
     // return the total net score of the capturing sequence
     return gain[0];
 }
+
+
+
+// seeGE
+//
+// Tell whether the static exchange evaluation of the move given is greater
+// than or equal to the threshold given, from the perspective of the side to
+// move. Unlike see(), the full capturing sequence is not resolved: the
+// exchange is followed only until its outcome, with respect to the
+// threshold, is decided.
+//
+// The balance (swap) is kept relative to the threshold: each side captures
+// with its least valuable attacker, and gives up as soon as it can't take
+// the balance back to its side. Castling and enpassant captures are taken
+// as even exchanges.
+bool seeGE(Move move, int threshold)
+{
+    // castling and enpassant captures can't lose material
+    if (getCastle(move) || getEp(move))
+        return (threshold <= 0);
+
+
+    int fromSq = getMoveSource(move);
+    int toSq   = getMoveTarget(move);
+
+
+    // the capture alone doesn't reach the threshold
+    int swap = ((occupancies[Both] & SqBB[toSq]) ? PieceValues[pieceOn(toSq)] : 0) - threshold;
+
+    if (swap < 0)
+        return false;
+
+
+    // the threshold is still reached even if the piece moved is lost
+    swap = PieceValues[getMovePiece(move)] - swap;
+
+    if (swap <= 0)
+        return true;
+
+
+    // temporary bitboards to run the exchange simulation
+    Bitboard occupied  = occupancies[Both] ^ SqBB[fromSq] ^ SqBB[toSq];
+    Bitboard diagonal  = bitboards[B] | bitboards[b] | bitboards[Q] | bitboards[q];
+    Bitboard straight  = bitboards[R] | bitboards[r] | bitboards[Q] | bitboards[q];
+    Bitboard stmAttackers, bb;
+
+
+    // attackers of both sides, with a single lookup per slider type
+    Bitboard attackers = (PawnAttacks[Black][toSq] & bitboards[P]) |
+                         (PawnAttacks[White][toSq] & bitboards[p]) |
+                         (KnightAttacks[toSq] & (bitboards[N] | bitboards[n])) |
+                         (KingAttacks[toSq] & (bitboards[K] | bitboards[k])) |
+                         (getBishopAttacks(toSq, occupied) & diagonal) |
+                         (getRookAttacks(toSq, occupied) & straight);
+
+    int stm = sideToMove;
+    int res = 1;
+
+
+    // each side captures in turn with its least valuable attacker, and the
+    // x-ray attackers behind it join the exchange
+    while (true)
+    {
+        stm ^= 1;
+        attackers &= occupied;
+
+        if (!(stmAttackers = attackers & occupancies[stm]))
+            break;
+
+        res ^= 1;
+
+        int Us = (stm == White) ? P : p;
+
+        if ((bb = stmAttackers & bitboards[Us + P]))
+        {
+            if ((swap = PieceValues[P] - swap) < res)
+                break;
+
+            occupied ^= bb & -bb;
+            attackers |= getBishopAttacks(toSq, occupied) & diagonal;
+        }
+
+        else if ((bb = stmAttackers & bitboards[Us + N]))
+        {
+            if ((swap = PieceValues[N] - swap) < res)
+                break;
+
+            occupied ^= bb & -bb;
+        }
+
+        else if ((bb = stmAttackers & bitboards[Us + B]))
+        {
+            if ((swap = PieceValues[B] - swap) < res)
+                break;
+
+            occupied ^= bb & -bb;
+            attackers |= getBishopAttacks(toSq, occupied) & diagonal;
+        }
+
+        else if ((bb = stmAttackers & bitboards[Us + R]))
+        {
+            if ((swap = PieceValues[R] - swap) < res)
+                break;
+
+            occupied ^= bb & -bb;
+            attackers |= getRookAttacks(toSq, occupied) & straight;
+        }
+
+        else if ((bb = stmAttackers & bitboards[Us + Q]))
+        {
+            if ((swap = PieceValues[Q] - swap) < res)
+                break;
+
+            occupied ^= bb & -bb;
+            attackers |= (getBishopAttacks(toSq, occupied) & diagonal) |
+                         (getRookAttacks(toSq, occupied) & straight);
+        }
+
+        // the King can only capture if the square is no longer defended
+        else
+            return (attackers & ~occupancies[stm]) ? (res ^ 1) : res;
+    }
+
+
+    return res;
+}
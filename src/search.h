@@ -21,6 +21,7 @@
 #ifndef SEARCH_H
 #define SEARCH_H
 
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <string>
@@ -35,6 +36,7 @@
 #endif
 
 #include "movgen.h"
+#include "trace.h"
 
 
 
@@ -49,10 +51,12 @@ using namespace std;
 #define DefaultMovetime            5000
 #define LMRFullDepthMoves             4
 #define LMRReductionLimit             3
+#define LMRTableSize                 64
 #define AspirationWindow             70
 #define WatchIntervalMs              10
 
 #define MaxSearchTime  0xFFFFFFFFFFFFFFFFULL
+#define MaxSearchNodes 0xFFFFFFFFFFFFFFFFULL
 
 
 
@@ -64,12 +68,20 @@ using namespace std;
 
 
 
+// Score given to a position that the tablebases report as won (or lost),
+// minus the distance to the root. It is kept below MateScore, so that TB
+// wins are never reported (nor adjusted in the TT) as mate scores.
+#define TBWinScore      (MateScore - MaxPly)
+
+
+
 
 // Default options (settings) at startup
 #define OptionsDefaultHashSize      1024 
 #define OptionsDefaultContempt        25
 #define OptionsContemptMin             0
 #define OptionsContemptMax           200
+#define OptionsNodestimeMax        10000
 
 
 
@@ -86,6 +98,23 @@ using namespace std;
 
 
 
+// Score assigned to the countermove of the previous move. Quiet moves are
+// sorted after the killers (9000 and 8000) and the countermove, by their
+// history score divided by MoveScoreHistoryDivisor, which keeps the sum of
+// the 3 history tables (@see quietHistory()) below the countermove.
+#define MoveScoreCounter          7000
+#define MoveScoreHistoryDivisor      4
+
+
+
+// Every entry of the history tables is kept within [-HistoryMax, HistoryMax]
+// (@see updateHistory()), and a single bonus or malus never goes beyond
+// HistoryBonusMax.
+#define HistoryMax                8192
+#define HistoryBonusMax           1536
+
+
+
 // 'nodes' is a global variable holding the number of nodes analyzed
 // or searched. It is used by negamax() but also other performance test
 // functions such as perft().
@@ -93,6 +122,20 @@ extern uint64_t nodes;
 
 
 
+// Maximum no. of nodes of the current search (go nodes, or nodestime), or
+// MaxSearchNodes if the search is not limited by nodes
+extern uint64_t maxNodes;
+
+
+
+// Nodes left on the engine's own clock when playing with nodestime: it starts
+// at the GUI's clock times npmsec, loses the nodes searched and gains the
+// increment (times npmsec) at every move. Zero until the first timed search
+// of a game.
+extern int64_t availableNodes;
+
+
+
 // Limits_t is a structure that holds the configuration of the search.
 // This includes search depth, time to search, etc.
 //
@@ -119,9 +162,28 @@ extern Limits_t Limits;
 
 
 
-// Map containing all the engine options that can be set using
-// the UCI command 'setoption'
-extern std::map<std::string, int> Options;
+// SearchOptions_t is a snapshot of the UCI options used by the search, taken
+// when the search starts, so that the search never has to look them up.
+//
+// @see UCI::snapshotOptions()
+typedef struct
+{
+    int  contempt;
+    int  nodestime;
+    bool ownBook;
+} SearchOptions_t;
+
+extern SearchOptions_t SearchOptions;
+
+
+
+// PlyMove_t is the move made at a given ply of the line being searched, and
+// the piece that moved. The move is 0 after a null move.
+typedef struct
+{
+    Move move;
+    int  piece;
+} PlyMove_t;
 
 
 
@@ -148,17 +210,46 @@ extern bool     timeset;
 // Note: storing exactly 2 killer moves is best for efficiency/performance.
 //
 // @see https://www.chessprogramming.org/Killer_Heuristic
-extern int killers[2][MaxPly];
+extern Move killers[2][MaxPly];
 
 
 
-// history [piece][square]
+// history [side][from][to]
 //
-// History is a table where to store moves that have produced an improvement in
-// the score of previous searches. In other words, they have raised alpha.
+// Butterfly history is a table of quiet moves scored by the beta cut-offs
+// they have produced in previous searches (bonus), minus the cut-offs they
+// have failed to produce when searched before another quiet move that did
+// produce one (malus).
 //
 // @see https://www.chessprogramming.org/History_Heuristic
-extern int history[12][64];
+extern int16_t history[2][64][64];
+
+
+
+// countermoves [piece][square]
+//
+// The last quiet move that produced a beta cut-off in reply to a move, indexed
+// by the piece and target square of that move.
+//
+// @see https://www.chessprogramming.org/Countermove_Heuristic
+extern Move counterMoves[12][64];
+
+
+
+// continuation history [piece][square][piece][square]
+//
+// History of quiet moves (piece and target square) in reply to the move made
+// 1 ply before, or 2 plies before (i.e., our own previous move). Both plies
+// share the same table, and are updated like the butterfly history.
+extern int16_t continuationHistory[12][64][12][64];
+
+
+
+// current move [ply]
+//
+// Move made at every ply of the line being searched, for indexing the
+// countermoves and the continuation history.
+extern PlyMove_t currentMove[MaxPly];
 
 
 
@@ -197,7 +288,7 @@ extern int pv_length[MaxPly];
 
 
 // PV table [ply][ply]
-extern int pv_table[MaxPly][MaxPly];
+extern Move pv_table[MaxPly][MaxPly];
 
 
 
@@ -254,14 +345,22 @@ static constexpr int mvv_lva[12][12] =
 
 
 
+// Type of a node of the search tree: the root, a node of the principal
+// variation (searched with an open window) or a non-PV node (searched with a
+// null window).
+enum NodeType { NonPV, PV, Root };
+
+
+
 // Functionality to search a position or perform an operation on the
 // nodes of a given position.
-void dperft(int);
+void dperft(int, uint32_t = 0, bool = false);
 void search();
-int  qsearch(int, int);
-int  see(int);
+template <NodeType Node> int qsearch(int, int);
+int  see(Move);
+bool seeGE(Move, int);
 void initSearch();
-void sortMoves(MoveList_t &, int);
+void sortMoves(MoveList_t &, Move);
 void printMoveScores(MoveList_t &);
 void resetLimits();
 void resetTimeControl();
@@ -271,21 +370,33 @@ void resetTimeControl();
 // perft
 //
 // Verify move generation. All the leaf nodes up to the given depth are
-// generated and counted.
+// generated and counted, and the number of leaf nodes is returned.
+//
+// perft() only works on the (thread-local) position and does not touch any
+// other global state, so it can be run on several threads at once. The
+// Hashed version looks up and stores the leaf counts of every subtree in the
+// perft table, so that transpositions are counted only once; the table must
+// have been allocated with PerftTT::init().
 // 
 // @see https://www.chessprogramming.org/Perft
-static inline void perft(int depth)
+template <bool Hashed = false>
+static inline uint64_t perft(int depth)
 {
     // reliability checks
     assert(depth >= 0);
+    assert(!Hashed || perft_total_entries);
 
 
-    // escape at leaf nodes and increment node count
+    // escape at leaf nodes and count the node
     if (depth == 0)
-    {
-        nodes++;
-        return;
-    }
+        return 1ULL;
+
+
+    // look up the subtree in the perft table
+    uint64_t leaves = 0ULL;
+
+    if (Hashed && PerftTT::probe(depth, leaves))
+        return leaves;
 
     
     // create move list instance
@@ -304,7 +415,7 @@ static inline void perft(int depth)
 
 
         // make move and, if illegal, skip to the next move
-        if (!makeMove(MoveList.moves[move_count]))
+        if (!makeMove(MoveList.moves[move_count].move))
         {
             takeBack();
             continue;
@@ -312,12 +423,20 @@ static inline void perft(int depth)
 
 
         // call perft driver recursively
-        perft(depth - 1);
+        leaves += perft<Hashed>(depth - 1);
 
         
         // undo move
         takeBack();
     }
+
+
+    // store the subtree in the perft table
+    if (Hashed)
+        PerftTT::save(depth, leaves);
+
+
+    return leaves;
 }
 
 
@@ -331,14 +450,42 @@ static inline void perft(int depth)
     3. Promotions
     4. 1st killer move
     5. 2nd killer move
-    6. History moves
-    7. Unsorted moves
+    6. Countermove
+    7. History moves (butterfly and continuation history)
 */
 
+// quietHistory
+//
+// Score a quiet move by its history: the sum of its butterfly history and its
+// continuation history after the moves made 1 and 2 plies before. The move
+// must not have been made yet.
+static inline int quietHistory(Move move)
+{
+    int piece = getMovePiece(move);
+    int toSq  = getMoveTarget(move);
+    int score = history[sideToMove][getMoveSource(move)][toSq];
+
+
+    // there is no continuation after the root or a null move
+    for (int i = 1; (i <= 2) && (i <= ply); i++)
+    {
+        const PlyMove_t &prev = currentMove[ply - i];
+
+        if (prev.move)
+            score += continuationHistory[prev.piece][getMoveTarget(prev.move)][piece][toSq];
+    }
+
+
+    return score;
+}
+
+
+
+
 // scoreMove
 //
 // Assign a score to a move.
-static inline int scoreMove(int move)
+static inline int scoreMove(Move move)
 {
     // if PV move scoring is allowed
     // if PV move and scoring allowed, assign it the highest score
@@ -406,9 +553,15 @@ static inline int scoreMove(int move)
         else if (killers[1][ply] == move)
             return 8000;
         
+        // score the countermove of the previous move
+        else if (ply && currentMove[ply - 1].move
+                     && (counterMoves[currentMove[ply - 1].piece]
+                                     [getMoveTarget(currentMove[ply - 1].move)] == move))
+            return MoveScoreCounter;
+
         // score history move
         else
-            return history[getMovePiece(move)][getMoveTarget(move)];
+            return quietHistory(move) / MoveScoreHistoryDivisor;
     }
    
 
@@ -431,7 +584,7 @@ static inline void enablePV_scoring(MoveList_t &MoveList)
     for (int count = 0; count < MoveList.count; count++)
     {
         // make sure we hit PV move
-        if (pv_table[0][ply] == MoveList.moves[count])
+        if (pv_table[0][ply] == MoveList.moves[count].move)
         {
             // enable move scoring and follow PV again
             scorePV  = true;
@@ -522,7 +675,10 @@ static inline void watchClockAndInput()
     {
         // watch clock
         if (timeset && (getTimeInMilliseconds() > stoptime))
+        {
+            Trace::instant("time up");
             timedout = true;
+        }
 
 
         // read the input
@@ -530,13 +686,12 @@ static inline void watchClockAndInput()
         {
             cin >> cmd;
             if (cmd == "stop")
+            {
+                Trace::instant("stop");
                 timedout = true;
+            }
         }
 
-        // check for nodes limitation
-        else if ((Limits.nodes > 0) && (nodes > Limits.nodes))
-            timedout = true;
-
 
         // update interval 
         this_thread::sleep_for(chrono::milliseconds(WatchIntervalMs));
@@ -545,20 +700,31 @@ static inline void watchClockAndInput()
 
 
 
+// nodeLimitReached
+//
+// Return true, and stop the search, once the search has visited all the nodes
+// allowed. This is checked by negamax() and qsearch() before counting every
+// node, so that the search stops at exactly the same node on every run and
+// 'go nodes' is reproducible.
+static inline bool nodeLimitReached()
+{
+    if (nodes < maxNodes)
+        return false;
+
+    timedout = true;
+    return true;
+}
+
+
+
 // isEndgame
 //
 // Determine if the current position should be considered an endgame
-// position for the current side to move.
+// position for the current side to move, i.e., the material left on the
+// board is worth less than 2600 (@see computeMaterial()).
 static inline bool isEndgame()
 {
-    int pawn_material   = countBits(bitboards[P] | bitboards[p]) * 100;
-    int knight_material = countBits(bitboards[N] | bitboards[n]) * 320;
-    int bishop_material = countBits(bitboards[B] | bitboards[b]) * 320;
-    int rook_material   = countBits(bitboards[R] | bitboards[r]) * 500;
-    int queen_material  = countBits(bitboards[Q] | bitboards[q]) * 950;
-
-	return ((pawn_material + knight_material + bishop_material
-                           + rook_material + queen_material) < 2600);
+    return probeMaterial(material_key)->endgame;
 }
 
 
@@ -578,7 +744,7 @@ static inline int contempt()
 
     // in the opening and middle game, we try to fight
     else
-        return ((sideToMove == White) ? -Options["Contempt"] : Options["Contempt"]);
+        return ((sideToMove == White) ? -SearchOptions.contempt : SearchOptions.contempt);
 }
 
 
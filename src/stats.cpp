@@ -0,0 +1,237 @@
+/*
+  This file is part of Gargantua, a UCI chess engine with NNUE evaluation
+  derived from Chess0, and inspired by Code Monkey King's bbc-1.4.
+
+  Copyright (C) 2025 Claudio M. Camacho
+
+  Gargantua is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Gargantua is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <cstring>
+
+#include "search.h"
+#include "stats.h"
+
+
+
+using namespace std;
+
+
+
+// Statistics of the current search, per thread
+thread_local SearchStats_t searchStats;
+
+
+
+// Snapshots of the main thread's statistics at the end of every iteration of
+// the last search, and the last depth completed
+static SearchStats_t iterations[MaxPly + 1];
+static int lastDepth = 0;
+
+
+
+// no. of counters in SearchStats_t
+#define StatsCounters   (sizeof(SearchStats_t) / sizeof(uint64_t))
+
+
+
+#ifdef USE_STATS
+
+// iterationStats
+//
+// Return the statistics of the given iteration alone, i.e., the difference
+// between its snapshot and the previous iteration's.
+static SearchStats_t iterationStats(int depth)
+{
+    SearchStats_t delta;
+
+    uint64_t       *d    = (uint64_t *) &delta;
+    const uint64_t *curr = (const uint64_t *) &iterations[depth];
+    const uint64_t *prev = (const uint64_t *) &iterations[depth - 1];
+
+    for (size_t i = 0; i < StatsCounters; i++)
+        d[i] = curr[i] - prev[i];
+
+    return delta;
+}
+
+
+
+// percent
+//
+// Return a as a percentage of b, or zero if b is zero.
+static inline double percent(uint64_t a, uint64_t b)
+{
+    return b ? 100.0 * a / b : 0.0;
+}
+
+
+
+// ebf
+//
+// Return the effective branching factor estimated at the given depth. The
+// nodes of an iteration are compared to those of two iterations before, to
+// smooth out the odd-even effect of alpha-beta.
+static double ebf(int depth)
+{
+    if (depth < 2)
+        return 0.0;
+
+    if (depth == 2)
+    {
+        uint64_t n1 = iterationStats(1).nodes;
+        return n1 ? double(iterationStats(2).nodes) / n1 : 0.0;
+    }
+
+    uint64_t n = iterationStats(depth - 2).nodes;
+
+    return n ? sqrt(double(iterationStats(depth).nodes) / n) : 0.0;
+}
+
+#endif  //  USE_STATS
+
+
+
+// Stats::clear
+//
+// Reset the statistics of the current thread and the snapshots of the last
+// search. Called at the start of every search.
+void Stats::clear()
+{
+    memset(&searchStats, 0, sizeof(searchStats));
+    memset(iterations, 0, sizeof(iterations));
+    lastDepth = 0;
+}
+
+
+
+// Stats::endIteration
+//
+// Take a snapshot of the statistics at the end of an iteration of the
+// iterative deepening loop.
+void Stats::endIteration(int depth)
+{
+    if ((depth < 1) || (depth > MaxPly))
+        return;
+
+    iterations[depth] = searchStats;
+    iterations[depth].nodes = nodes;
+
+    lastDepth = depth;
+}
+
+
+
+// Stats::print
+//
+// Print the statistics of the last search, one line per depth (iteration).
+void Stats::print()
+{
+#ifndef USE_STATS
+    cout << "Search statistics are not available in this build (make stats=yes)" << endl;
+#else
+    if (lastDepth == 0)
+    {
+        cout << "No search statistics available yet" << endl;
+        return;
+    }
+
+
+    // header
+    cout << endl;
+    cout << "depth       nodes    ebf   qs%  tthit%   ttcut  qtthit%  qttcut  betacut  first%  qfirst%"
+            "    null  null%   razor     rfp  futile     lmp     lmr  lmr-re     see      evals"
+         << endl;
+
+
+    // one line per iteration
+    cout << fixed;
+
+    for (int depth = 1; depth <= lastDepth; depth++)
+    {
+        SearchStats_t s = iterationStats(depth);
+
+        cout << setw(5)  << depth
+             << setw(12) << s.nodes
+             << setw(7)  << setprecision(2) << ebf(depth)
+             << setw(6)  << setprecision(1) << percent(s.qnodes, s.nodes)
+             << setw(8)  << percent(s.ttHits, s.ttProbes)
+             << setw(8)  << s.ttCutoffs
+             << setw(9)  << percent(s.qsTTHits, s.qsTTProbes)
+             << setw(8)  << s.qsTTCutoffs
+             << setw(9)  << s.betaCutoffs
+             << setw(8)  << percent(s.firstMoveCutoffs, s.betaCutoffs)
+             << setw(9)  << percent(s.firstQuietCutoffs, s.quietCutoffs)
+             << setw(8)  << s.nullTries
+             << setw(7)  << percent(s.nullCutoffs, s.nullTries)
+             << setw(8)  << s.razorPrunes
+             << setw(8)  << s.rfpPrunes
+             << setw(8)  << s.futilityPrunes
+             << setw(8)  << s.lmpPrunes
+             << setw(8)  << s.lmrReductions
+             << setw(8)  << s.lmrResearches
+             << setw(8)  << s.seePrunes
+             << setw(11) << s.evals
+             << endl;
+    }
+
+    cout << endl;
+
+
+    // reset formating
+    cout << resetiosflags(cout.flags());
+#endif
+}
+
+
+
+// Stats::printSummary
+//
+// Print the totals of the search as an 'info string' line, at the end of the
+// search. Nothing is printed unless the statistics are built in.
+void Stats::printSummary()
+{
+#ifdef USE_STATS
+    SearchStats_t s = searchStats;
+    s.nodes = nodes;
+
+    cout << fixed << setprecision(1);
+    cout << "info string stats"
+         << " nodes "     << s.nodes
+         << " qnodes "    << percent(s.qnodes, s.nodes) << "%"
+         << " evals "     << s.evals
+         << " tthits "    << percent(s.ttHits, s.ttProbes) << "%"
+         << " ttcuts "    << s.ttCutoffs
+         << " qtthits "   << percent(s.qsTTHits, s.qsTTProbes) << "%"
+         << " qttcuts "   << s.qsTTCutoffs
+         << " betacuts "  << s.betaCutoffs
+         << " firstmove " << percent(s.firstMoveCutoffs, s.betaCutoffs) << "%"
+         << " firstquiet " << percent(s.firstQuietCutoffs, s.quietCutoffs) << "%"
+         << " null "      << s.nullCutoffs << "/" << s.nullTries
+         << " razor "     << s.razorPrunes
+         << " rfp "       << s.rfpPrunes
+         << " futility "  << s.futilityPrunes
+         << " lmp "       << s.lmpPrunes
+         << " lmr "       << s.lmrResearches << "/" << s.lmrReductions
+         << " see "       << s.seePrunes
+         << setprecision(2)
+         << " ebf "       << ebf(lastDepth)
+         << endl;
+
+    cout << resetiosflags(cout.flags());
+#endif
+}
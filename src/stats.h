@@ -0,0 +1,93 @@
+/*
+  This file is part of Gargantua, a UCI chess engine with NNUE evaluation
+  derived from Chess0, and inspired by Code Monkey King's bbc-1.4.
+
+  Copyright (C) 2025 Claudio M. Camacho
+
+  Gargantua is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Gargantua is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <cstdint>
+
+
+
+// Search statistics:
+//
+// Counters of what happens inside the search (hash table hits, cutoffs,
+// pruning, reductions, etc.), used to tune the search. Each thread counts
+// into its own copy of SearchStats_t, so that counting never contends.
+//
+// The counters only exist in builds with USE_STATS defined (debug builds,
+// or 'make stats=yes'); otherwise STAT() compiles to nothing, and release
+// builds don't pay for the instrumentation at all.
+typedef struct
+{
+    uint64_t nodes;
+    uint64_t qnodes;
+    uint64_t evals;
+    uint64_t ttProbes;
+    uint64_t ttHits;
+    uint64_t ttCutoffs;
+    uint64_t qsTTProbes;
+    uint64_t qsTTHits;
+    uint64_t qsTTCutoffs;
+    uint64_t betaCutoffs;
+    uint64_t firstMoveCutoffs;
+    uint64_t quietCutoffs;
+    uint64_t firstQuietCutoffs;
+    uint64_t nullTries;
+    uint64_t nullCutoffs;
+    uint64_t razorPrunes;
+    uint64_t rfpPrunes;
+    uint64_t futilityPrunes;
+    uint64_t lmpPrunes;
+    uint64_t lmrReductions;
+    uint64_t lmrResearches;
+    uint64_t seePrunes;
+} SearchStats_t;
+
+extern thread_local SearchStats_t searchStats;
+
+
+
+// STAT(counter)
+//
+// Increment the given counter of the current thread's search statistics.
+#ifdef USE_STATS
+    #define STAT(counter)   (searchStats.counter++)
+#else
+    #define STAT(counter)   ((void) 0)
+#endif
+
+
+
+// Search statistics interface: reset the counters at the start of a search,
+// take a snapshot at the end of every iteration, and print them per depth
+// ('stats' command) or as a summary at the end of the search.
+namespace Stats
+{
+
+void clear();
+void endIteration(int);
+void print();
+void printSummary();
+
+}  //  namespace Stats
+
+
+
+#endif  //  STATS_H
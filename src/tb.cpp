@@ -0,0 +1,260 @@
+/*
+  This file is part of Gargantua, a UCI chess engine with NNUE evaluation
+  derived from Chess0, and inspired by Code Monkey King's bbc-1.4.
+
+  Copyright (C) 2025 Claudio M. Camacho
+
+  Gargantua is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Gargantua is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <cstdlib>
+#include <cassert>
+
+#include "bitboard.h"
+#include "position.h"
+#include "tb.h"
+#include "tbprobe.h"
+
+
+
+using namespace std;
+
+
+
+// Counter of successful tablebase probes during the current search
+uint64_t tbhits = 0ULL;
+
+
+
+// WDL result cache:
+//
+// A fixed-size array of 64-bit words, each one holding the upper bits of the
+// position's hash key and the WDL result (plus one) in the lowest 3 bits. An
+// empty slot is zero. Because every entry is a single word read and written
+// atomically, the cache is lock-free and can never return a torn entry;
+// concurrent writers simply overwrite each other.
+static uint64_t *wdl_cache = nullptr;
+static uint64_t  wdl_cache_entries = 0ULL;
+
+// cache usage statistics
+static atomic<uint64_t> wdl_cache_probes(0);
+static atomic<uint64_t> wdl_cache_hits(0);
+
+// bits of the cache entry reserved for the WDL result
+#define WDLCacheMask 7ULL
+
+
+
+// Whether to preload the smaller tables after loading the tablebases
+static bool preload = false;
+
+
+
+// flipVertical
+//
+// Gargantua numbers the squares from a8 (0) to h1 (63), whereas Pyrrhic
+// numbers them from a1 (0) to h8 (63). Mirroring the ranks of a Bitboard
+// translates it from one layout to the other.
+static inline Bitboard flipVertical(Bitboard bb)
+{
+    return __builtin_bswap64(bb);
+}
+
+
+
+// TB::init
+//
+// Load the Syzygy tablebases found in the given path (a list of directories
+// separated by ':', or ';' on Windows). An empty path or "<empty>" disables
+// the tablebases.
+bool TB::init(const string &path)
+{
+    // any cached result may belong to a different set of tables
+    TB::clearCache();
+
+
+    // load the tables and start preloading them, if enabled
+    bool ok = tb_init(path.c_str());
+
+    if (ok && preload)
+        tb_preload(SyzygyPreloadPieces);
+
+
+    return ok;
+}
+
+
+
+// TB::setPreload
+//
+// Enable or disable the preloading of the smaller tables (up to
+// SyzygyPreloadPieces men) into memory, in a background thread. This takes
+// effect immediately for the tables already loaded.
+void TB::setPreload(bool enabled)
+{
+    preload = enabled;
+
+    tb_preload(preload ? SyzygyPreloadPieces : 0);
+}
+
+
+
+// TB::initCache
+//
+// Dynamically allocate memory for the WDL result cache (in MBytes). A size
+// of zero disables the cache.
+void TB::initCache(uint32_t mb)
+{
+    // free the previous cache, if any
+    if (wdl_cache != nullptr)
+        free(wdl_cache);
+
+    wdl_cache = nullptr;
+    wdl_cache_entries = 0ULL;
+
+
+    // cache disabled
+    if (mb == 0)
+        return;
+
+
+    // allocate memory and reset all entries
+    uint64_t entries = (uint64_t(mb) * 1024 * 1024) / sizeof(uint64_t);
+    wdl_cache = (uint64_t *) calloc(entries, sizeof(uint64_t));
+
+    if (wdl_cache == nullptr)
+        cout << "Couldn't allocate memory for Syzygy cache!" << endl;
+    else
+        wdl_cache_entries = entries;
+
+
+    // reset the statistics
+    wdl_cache_probes = 0;
+    wdl_cache_hits   = 0;
+}
+
+
+
+// TB::clearCache
+//
+// Reset all the entries of the WDL result cache.
+void TB::clearCache()
+{
+    for (uint64_t i = 0; i < wdl_cache_entries; i++)
+        atomic_ref<uint64_t>(wdl_cache[i]).store(0ULL, memory_order_relaxed);
+
+    wdl_cache_probes = 0;
+    wdl_cache_hits   = 0;
+}
+
+
+
+// TB::canProbe
+//
+// Return true if the current position has few enough pieces to be found in
+// the tablebases loaded, and no castling rights.
+bool TB::canProbe()
+{
+    return TB_LARGEST && !castle && (countBits(occupancies[Both]) <= TB_LARGEST);
+}
+
+
+
+// TB::probeWDL
+//
+// Probe the Win-Draw-Loss tables for the current position. The return value
+// is one of TB_LOSS, TB_BLESSED_LOSS, TB_DRAW, TB_CURSED_WIN or TB_WIN, from
+// the point of view of the side to move, or TB_RESULT_FAILED.
+//
+// Results are cached by hash key, so that transpositions (very frequent in
+// endgames) are answered without touching the table files.
+unsigned TB::probeWDL()
+{
+    // reliability checks
+    assert(TB::canProbe());
+
+
+    // look up the position in the result cache first
+    uint64_t *slot = nullptr;
+
+    if (wdl_cache_entries)
+    {
+        slot = &wdl_cache[hash_key % wdl_cache_entries];
+
+        uint64_t entry = atomic_ref<uint64_t>(*slot).load(memory_order_relaxed);
+
+        wdl_cache_probes.fetch_add(1, memory_order_relaxed);
+
+        if (entry && !((entry ^ hash_key) & ~WDLCacheMask))
+        {
+            wdl_cache_hits.fetch_add(1, memory_order_relaxed);
+            return unsigned(entry & WDLCacheMask) - 1;
+        }
+    }
+
+
+    // probe the tables, translating the position to Pyrrhic's layout
+    unsigned wdl = tb_probe_wdl(flipVertical(occupancies[White]),
+                                flipVertical(occupancies[Black]),
+                                flipVertical(bitboards[K] | bitboards[k]),
+                                flipVertical(bitboards[Q] | bitboards[q]),
+                                flipVertical(bitboards[R] | bitboards[r]),
+                                flipVertical(bitboards[B] | bitboards[b]),
+                                flipVertical(bitboards[N] | bitboards[n]),
+                                flipVertical(bitboards[P] | bitboards[p]),
+                                (epsq == NoSq) ? 0 : (epsq ^ 56),
+                                sideToMove == White);
+
+
+    // store successful probes in the result cache
+    if (slot && (wdl != TB_RESULT_FAILED))
+        atomic_ref<uint64_t>(*slot).store((hash_key & ~WDLCacheMask) | (wdl + 1),
+                                          memory_order_relaxed);
+
+
+    return wdl;
+}
+
+
+
+// TB::printStats
+//
+// Print the usage of the tablebases and their caches (hit rates).
+void TB::printStats()
+{
+    uint64_t probes = wdl_cache_probes;
+    uint64_t hits   = wdl_cache_hits;
+    uint64_t block_probes, block_hits;
+
+    tb_block_cache_stats(&block_probes, &block_hits);
+
+
+    cout << fixed << setprecision(1);
+    cout << "Syzygy tablebases: " << TB_LARGEST << "-men" << endl;
+
+    cout << "  WDL cache:   " << wdl_cache_entries << " entries, "
+         << hits << "/" << probes << " hits ("
+         << (probes ? 100.0 * hits / probes : 0.0) << "%)" << endl;
+
+    cout << "  Block cache: " << block_hits << "/" << block_probes << " hits ("
+         << (block_probes ? 100.0 * block_hits / block_probes : 0.0) << "%)"
+         << endl << endl;
+
+
+    // reset formating
+    cout << resetiosflags(cout.flags());
+}
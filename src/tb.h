@@ -0,0 +1,74 @@
+/*
+  This file is part of Gargantua, a UCI chess engine with NNUE evaluation
+  derived from Chess0, and inspired by Code Monkey King's bbc-1.4.
+
+  Copyright (C) 2025 Claudio M. Camacho
+
+  Gargantua is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Gargantua is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TB_H
+#define TB_H
+
+#include <string>
+#include <cstdint>
+
+
+
+// Default sizes for the Syzygy caches:
+//
+// SyzygyCache is the size (in MBytes) of the WDL result cache, shared by all
+// threads. SyzygyBlockCache is the number of decompressed blocks that each
+// thread keeps in its own LRU list.
+#define SyzygyCacheDefault          16
+#define SyzygyCacheMin               0
+#define SyzygyCacheMax            1024
+#define SyzygyBlockCacheDefault     16
+#define SyzygyBlockCacheMin          0
+#define SyzygyBlockCacheMax         64
+
+
+
+// Largest tables (in number of men) loaded into memory in the background
+// when the SyzygyPreload option is enabled. These are by far the most probed.
+#define SyzygyPreloadPieces          5
+
+
+
+// Counter of successful tablebase probes during the current search; this is
+// reported as 'tbhits' in the UCI info lines.
+extern uint64_t tbhits;
+
+
+
+// Syzygy tablebases interface. This is a thin layer over Pyrrhic (tbprobe.h)
+// that translates the engine's position into Pyrrhic's format and caches
+// the WDL results, so that repeated probes of the same position never go
+// back to the (possibly cold) mmapped table files.
+namespace TB
+{
+
+bool init(const std::string &);
+void initCache(uint32_t);
+void clearCache();
+void setPreload(bool);
+bool canProbe();
+unsigned probeWDL();
+void printStats();
+
+}  //  namespace TB
+
+
+
+#endif  //  TB_H
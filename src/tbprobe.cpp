@@ -32,6 +32,7 @@
 
 #ifdef __cplusplus
     #include <atomic>
+    #include <thread>
 #else
     #include <stdatomic.h>
 #endif
@@ -54,6 +55,7 @@ using namespace std;
 #define TB_MOVE_CHECKMATE       (0xFFFE)
 
 #ifndef _WIN32
+#include <dirent.h>
 #include <fcntl.h>
 #include <pthread.h>
 #include <unistd.h>
@@ -119,66 +121,163 @@ static uint32_t from_be_u32(uint32_t x) { return bswap32(x); }
 inline static uint32_t read_le_u32(void *p) { return from_le_u32(*(uint32_t *)p); }
 inline static uint16_t read_le_u16(void *p) { return from_le_u16(*(uint16_t *)p); }
 
-static size_t file_size(FD fd) {
+static LOCK_T tbMutex;
+static int initialized = 0;
+static int numPaths = 0;
+static char *pathString = NULL;
+static char **paths = NULL;
+
+// Index of the tablebase files present in the configured directories.
+//
+// tb_init() lists every directory once and records the tablebase files found
+// there, sorted by name (the first directory in the path wins). Testing and
+// opening a candidate table is then a binary search over this index, rather
+// than one failed open() per candidate and path component, which amounts to
+// thousands of system calls with a full 7-men set on a slow filesystem.
+struct TbFile {
+  char name[24];
+  int dir;
+  size_t size;
+};
+
+static struct TbFile *tbFiles = NULL;
+static int numTbFiles = 0;
+
+static int tb_file_cmp(const void *a, const void *b)
+{
+  const struct TbFile *fa = (const struct TbFile *)a;
+  const struct TbFile *fb = (const struct TbFile *)b;
+  int cmp = strcmp(fa->name, fb->name);
+  return cmp ? cmp : fa->dir - fb->dir;
+}
+
+static int tb_file_name_cmp(const void *a, const void *b)
+{
+  return strcmp(((const struct TbFile *)a)->name,
+                ((const struct TbFile *)b)->name);
+}
+
+static bool is_tb_file_name(const char *name)
+{
+  size_t len = strlen(name);
+  return len > 5 && len < sizeof(((struct TbFile *)0)->name)
+      && !strncmp(name + len - 5, ".rtb", 4) && strchr("wmz", name[len - 1]);
+}
+
+static char *tb_file_path(const char *dir, const char *name, const char *suffix)
+{
+  char *file = (char*)malloc(strlen(dir) + strlen(name) + strlen(suffix) + 2);
+  strcpy(file, dir);
 #ifdef _WIN32
-  LARGE_INTEGER fileSize;
-  if (GetFileSizeEx(fd, &fileSize)==0) {
-    return 0;
-  }
-  return (size_t)fileSize.QuadPart;
+  strcat(file,"\\");
 #else
-  struct stat buf;
-  if (fstat(fd,&buf)) {
-    return 0;
-  } else {
-    return buf.st_size;
+  strcat(file,"/");
+#endif
+  strcat(file, name);
+  strcat(file, suffix);
+  return file;
+}
+
+static void add_tb_file(const char *name, int dir, size_t size, int *capacity)
+{
+  if (numTbFiles == *capacity) {
+    *capacity = *capacity ? 2 * *capacity : 1024;
+    tbFiles = (struct TbFile*)realloc(tbFiles, *capacity * sizeof(*tbFiles));
+    if (!tbFiles) {
+      fprintf(stderr, "Out of memory.\n");
+      exit(EXIT_FAILURE);
+    }
   }
+  strcpy(tbFiles[numTbFiles].name, name);
+  tbFiles[numTbFiles].dir = dir;
+  tbFiles[numTbFiles].size = size;
+  numTbFiles++;
+}
+
+static void scan_tb_dirs(void)
+{
+  int capacity = 0;
+
+  for (int i = 0; i < numPaths; i++) {
+#ifndef _WIN32
+    DIR *dir = opendir(paths[i]);
+    if (!dir)
+      continue;
+    struct dirent *de;
+    while ((de = readdir(dir)) != NULL) {
+      if (!is_tb_file_name(de->d_name))
+        continue;
+      char *file = tb_file_path(paths[i], de->d_name, "");
+      struct stat statbuf;
+      if (!stat(file, &statbuf) && S_ISREG(statbuf.st_mode))
+        add_tb_file(de->d_name, i, statbuf.st_size, &capacity);
+      free(file);
+    }
+    closedir(dir);
+#else
+    char *pattern = tb_file_path(paths[i], "*.rtb?", "");
+    WIN32_FIND_DATAA data;
+    HANDLE h = FindFirstFileA(pattern, &data);
+    free(pattern);
+    if (h == INVALID_HANDLE_VALUE)
+      continue;
+    do {
+      if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+          && is_tb_file_name(data.cFileName))
+        add_tb_file(data.cFileName, i,
+                    (size_t)(((uint64_t)data.nFileSizeHigh << 32) | data.nFileSizeLow),
+                    &capacity);
+    } while (FindNextFileA(h, &data));
+    FindClose(h);
 #endif
+  }
+
+  // sort by name and keep only the first directory holding each file
+  qsort(tbFiles, numTbFiles, sizeof(*tbFiles), tb_file_cmp);
+  int n = 0;
+  for (int i = 0; i < numTbFiles; i++)
+    if (!n || strcmp(tbFiles[n - 1].name, tbFiles[i].name))
+      tbFiles[n++] = tbFiles[i];
+  numTbFiles = n;
 }
 
-static LOCK_T tbMutex;
-static int initialized = 0;
-static int numPaths = 0;
-static char *pathString = NULL;
-static char **paths = NULL;
+static const struct TbFile *find_tb_file(const char *str, const char *suffix)
+{
+  struct TbFile key;
+  if (strlen(str) + strlen(suffix) >= sizeof(key.name))
+    return NULL;
+  strcpy(key.name, str);
+  strcat(key.name, suffix);
+  return (const struct TbFile *)bsearch(&key, tbFiles, numTbFiles,
+                                        sizeof(*tbFiles), tb_file_name_cmp);
+}
 
 static FD open_tb(const char *str, const char *suffix)
 {
-  int i;
   FD fd;
   char *file;
+  const struct TbFile *f = find_tb_file(str, suffix);
 
-  for (i = 0; i < numPaths; i++) {
-    file = (char*)malloc(strlen(paths[i]) + strlen(str) +
-                         strlen(suffix) + 2);
-    strcpy(file, paths[i]);
-#ifdef _WIN32
-    strcat(file,"\\");
-#else
-    strcat(file,"/");
-#endif
-    strcat(file, str);
-    strcat(file, suffix);
+  if (!f)
+    return FD_ERR;
+
+  file = tb_file_path(paths[f->dir], f->name, "");
 #ifndef _WIN32
-    fd = open(file, O_RDONLY);
+  fd = open(file, O_RDONLY);
 #else
 #ifdef _UNICODE
-    wchar_t ucode_name[4096];
-    size_t len;
-    mbstowcs_s(&len, ucode_name, 4096, file, _TRUNCATE);
-    fd = CreateFile(ucode_name, GENERIC_READ, FILE_SHARE_READ, NULL,
-			  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  wchar_t ucode_name[4096];
+  size_t len;
+  mbstowcs_s(&len, ucode_name, 4096, file, _TRUNCATE);
+  fd = CreateFile(ucode_name, GENERIC_READ, FILE_SHARE_READ, NULL,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
 #else
-    fd = CreateFile(file, GENERIC_READ, FILE_SHARE_READ, NULL,
-			  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  fd = CreateFile(file, GENERIC_READ, FILE_SHARE_READ, NULL,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
 #endif
 #endif
-    free(file);
-    if (fd != FD_ERR) {
-      return fd;
-    }
-  }
-  return FD_ERR;
+  free(file);
+  return fd;
 }
 
 static void close_tb(FD fd)
@@ -228,7 +327,7 @@ static void *map_file(FD fd, map_t *mapping)
 static void unmap_file(void *data, map_t size)
 {
   if (!data) return;
-  if (!munmap(data, size)) {
+  if (munmap(data, size)) {
 	  perror("munmap");
   }
 }
@@ -280,6 +379,7 @@ struct EncInfo {
 
 struct BaseEntry {
   uint64_t key;
+  char name[16];
   uint8_t *data[3];
   map_t mapping[3];
 #ifdef __cplusplus
@@ -329,7 +429,76 @@ static struct PieceEntry *pieceEntry;
 static struct PawnEntry *pawnEntry;
 static struct TbHashEntry tbHash[1 << TB_HASHBITS];
 
+// Per-thread LRU cache of decompressed blocks.
+//
+// Decoding a probe walks the Huffman codes of its block from the start until
+// the requested literal is reached. Consecutive probes often land in the same
+// few blocks (e.g. the same endgame during a search), so each thread keeps
+// the fully decoded symbol list of its most recently used blocks. A hit only
+// needs a binary search over the symbol start offsets.
+//
+// Blocks decoding to more than TB_BLOCK_CACHE_SYMS symbols are not cached.
+#define TB_BLOCK_CACHE_SYMS 256
+
+struct BlockCacheEntry {
+  struct PairsData *d;
+  uint32_t block;
+  uint32_t stamp;
+  uint32_t numSyms;
+  uint16_t sym[TB_BLOCK_CACHE_SYMS];
+  uint16_t start[TB_BLOCK_CACHE_SYMS];
+};
+
+// The probe and hit counters are only written by the owning thread, so that
+// searching threads never contend on a shared cache line; they are atomic
+// only so that tb_block_cache_stats() may read them while a search runs.
+struct BlockCache {
+  uint32_t generation;
+  uint32_t stamp;
+  atomic<uint64_t> probes;
+  atomic<uint64_t> hits;
+  struct BlockCache *next;
+  struct BlockCacheEntry entry[TB_BLOCK_CACHE_MAX];
+};
+
+// The generation is bumped every time the tables are (re)loaded or the cache
+// is resized, so that threads drop entries pointing to stale PairsData.
+static atomic<uint32_t> blockCacheGeneration(1);
+static atomic<unsigned> blockCacheSize(0);
+static thread_local struct BlockCache blockCache;
+
+// Every thread that probes links its cache into this list, so that the
+// statistics can be summed on demand. A thread that exits moves its counts
+// into the retired totals.
+static LOCK_T blockCacheMutex;
+static struct BlockCache *blockCacheList = NULL;
+static uint64_t blockCacheRetiredProbes = 0;
+static uint64_t blockCacheRetiredHits = 0;
+
+struct BlockCacheOwner {
+  BlockCacheOwner() {
+    LOCK(blockCacheMutex);
+    blockCache.next = blockCacheList;
+    blockCacheList = &blockCache;
+    UNLOCK(blockCacheMutex);
+  }
+
+  ~BlockCacheOwner() {
+    LOCK(blockCacheMutex);
+    blockCacheRetiredProbes += blockCache.probes.load(memory_order_relaxed);
+    blockCacheRetiredHits += blockCache.hits.load(memory_order_relaxed);
+    struct BlockCache **link = &blockCacheList;
+    while (*link != &blockCache)
+      link = &(*link)->next;
+    *link = blockCache.next;
+    UNLOCK(blockCacheMutex);
+  }
+};
+
+static thread_local struct BlockCacheOwner blockCacheOwner;
+
 static void init_indices(void);
+static void stop_preload(void);
 
 // Forward declarations. These functions without the tb_
 // prefix take a pos structure as input.
@@ -459,21 +628,15 @@ static void prt_str(const PyrrhicPosition *pos, char *str, int flip) {
 
 static int test_tb(const char *str, const char *suffix) {
 
-    FD fd = open_tb(str, suffix);
+    const struct TbFile *f = find_tb_file(str, suffix);
 
-    if (fd != FD_ERR) {
-
-        size_t size = file_size(fd);
-        close_tb(fd);
-
-        if ((size & 63) != 16) {
-            fprintf(stderr, "Incomplete tablebase file %s.%s\n", str, suffix);
-            printf("info string Incomplete tablebase file %s.%s\n", str, suffix);
-            fd = FD_ERR;
-        }
+    if (f && (f->size & 63) != 16) {
+        fprintf(stderr, "Incomplete tablebase file %s.%s\n", str, suffix);
+        printf("info string Incomplete tablebase file %s.%s\n", str, suffix);
+        f = NULL;
     }
 
-    return fd != FD_ERR;
+    return f != NULL;
 }
 
 static void *map_tb(const char *name, const char *suffix, map_t *mapping) {
@@ -536,6 +699,7 @@ static void init_tb(char *str)
                                   : &pieceEntry[tbNumPiece++].be;
   be->hasPawns = hasPawns;
   be->key = key;
+  strcpy(be->name, str);
   be->symmetric = key == key2;
   be->num = 0;
   for (int i = 0; i < 16; i++)
@@ -612,8 +776,14 @@ bool tb_init(const char *path)
     initialized = 1;
   }
 
+  // the preloading thread walks the tables we are about to free
+  stop_preload();
+
   TB_LARGEST = 0;
 
+  // cached blocks point into the tables we are about to (re)load
+  tb_set_block_cache_size(blockCacheSize.load(memory_order_relaxed));
+
   // if pathString is set, we need to clean up first.
   if (pathString) {
     free(pathString);
@@ -626,6 +796,10 @@ bool tb_init(const char *path)
 
     LOCK_DESTROY(tbMutex);
 
+    free(tbFiles);
+    tbFiles = NULL;
+    numTbFiles = 0;
+
     pathString = NULL;
     numWdl = numDtm = numDtz = 0;
   }
@@ -652,6 +826,9 @@ bool tb_init(const char *path)
     while (pathString[j]) j++;
   }
 
+  // list the table files present, once for all candidates below
+  scan_tb_dirs();
+
   LOCK_INIT(tbMutex);
 
   tbNumPiece = tbNumPawn = 0;
@@ -1394,27 +1571,101 @@ static bool init_table(struct BaseEntry *be, const char *str, int type)
   return true;
 }
 
-static uint8_t *decompress_pairs(struct PairsData *d, size_t idx)
+// Background preloading of the WDL tables.
+//
+// Tables are otherwise mapped on their first probe, and their pages faulted
+// in one by one as the search walks them. The preloading thread maps the WDL
+// tables of up to maxPieces men (the ones probed most often) from the smallest
+// to the largest, and reads them into the page cache, so that the search
+// rarely has to wait for the disk.
+static thread preloadThread;
+static atomic<bool> preloadStop(false);
+
+static void preload_tables(int maxPieces)
 {
-  if (!d->idxBits)
-    return d->constValue;
+  for (int n = 3; n <= maxPieces; n++)
+    for (int i = 0; i < tbNumPiece + tbNumPawn; i++) {
+      if (atomic_load_explicit(&preloadStop, memory_order_relaxed))
+        return;
 
-  uint32_t mainIdx = (uint32_t)(idx >> d->idxBits);
-  int litIdx = (idx & (((size_t)1 << d->idxBits) - 1)) - ((size_t)1 << (d->idxBits - 1));
-  uint32_t block;
-  memcpy(&block, d->indexTable + 6 * mainIdx, sizeof(block));
-  block = from_le_u32(block);
+      struct BaseEntry *be = i < tbNumPiece ? &pieceEntry[i].be
+                                            : &pawnEntry[i - tbNumPiece].be;
+      if (be->num != n)
+        continue;
 
-  uint16_t idxOffset = *(uint16_t *)(d->indexTable + 6 * mainIdx + 4);
-  litIdx += from_le_u16(idxOffset);
+      LOCK(tbMutex);
+      if (!atomic_load_explicit(&be->ready[WDL], memory_order_relaxed)
+          && init_table(be, be->name, WDL))
+        atomic_store_explicit(&be->ready[WDL], true, memory_order_release);
+      UNLOCK(tbMutex);
 
-  if (litIdx < 0)
-    while (litIdx < 0)
-      litIdx += d->sizeTable[--block] + 1;
-  else
-    while (litIdx > d->sizeTable[block])
-      litIdx -= d->sizeTable[block++] + 1;
+      if (!atomic_load_explicit(&be->ready[WDL], memory_order_acquire))
+        continue;
+
+#ifndef _WIN32
+      // start the readahead of the whole file, then touch every page
+      uint8_t *data = be->data[WDL];
+      size_t size = be->mapping[WDL];
+      madvise(data, size, MADV_WILLNEED);
+      for (size_t off = 0; off < size; off += 4096) {
+        if (!(off & 0xfffff) && atomic_load_explicit(&preloadStop, memory_order_relaxed))
+          return;
+        (void)*(const volatile uint8_t *)(data + off);
+      }
+#endif
+    }
+}
 
+static void stop_preload(void)
+{
+  if (preloadThread.joinable()) {
+    atomic_store_explicit(&preloadStop, true, memory_order_relaxed);
+    preloadThread.join();
+  }
+  atomic_store_explicit(&preloadStop, false, memory_order_relaxed);
+}
+
+void tb_preload(int maxPieces)
+{
+  stop_preload();
+
+  if (pathString && maxPieces > 2)
+    preloadThread = thread(preload_tables, TB_MIN(maxPieces, TB_PIECES));
+}
+
+void tb_set_block_cache_size(unsigned entries)
+{
+  blockCacheSize.store(TB_MIN(entries, TB_BLOCK_CACHE_MAX), memory_order_relaxed);
+  blockCacheGeneration.fetch_add(1, memory_order_relaxed);
+
+  LOCK(blockCacheMutex);
+  blockCacheRetiredProbes = blockCacheRetiredHits = 0;
+  for (struct BlockCache *bc = blockCacheList; bc; bc = bc->next) {
+    bc->probes.store(0, memory_order_relaxed);
+    bc->hits.store(0, memory_order_relaxed);
+  }
+  UNLOCK(blockCacheMutex);
+}
+
+void tb_block_cache_stats(uint64_t *probes, uint64_t *hits)
+{
+  LOCK(blockCacheMutex);
+  *probes = blockCacheRetiredProbes;
+  *hits = blockCacheRetiredHits;
+  for (struct BlockCache *bc = blockCacheList; bc; bc = bc->next) {
+    *probes += bc->probes.load(memory_order_relaxed);
+    *hits += bc->hits.load(memory_order_relaxed);
+  }
+  UNLOCK(blockCacheMutex);
+}
+
+// Decode the Huffman code stream of the given block. With e == NULL, stop at
+// the symbol containing literal *litIdx and return it, leaving in *litIdx
+// the offset of the literal within that symbol. Otherwise, decode the whole
+// block into e and return 0, or TB_MAX_SYMS if it has too many symbols.
+static uint32_t decode_block(struct PairsData *d, uint32_t block, int *litIdx,
+    struct BlockCacheEntry *e)
+{
   uint32_t *ptr = (uint32_t *)(d->data + ((size_t)block << d->blockSize));
 
   int m = d->minLen;
@@ -1422,6 +1673,7 @@ static uint8_t *decompress_pairs(struct PairsData *d, size_t idx)
   uint64_t *base = d->base - m;
   uint8_t *symLen = d->symLen;
   uint32_t sym, bitCnt;
+  uint32_t total = (uint32_t)d->sizeTable[block] + 1, pos = 0;
 
 #ifdef DECOMP64
   uint64_t code = from_be_u64(*(uint64_t *)ptr);
@@ -1433,8 +1685,16 @@ static uint8_t *decompress_pairs(struct PairsData *d, size_t idx)
     while (code < base[l]) l++;
     sym = from_le_u16(offset[l]);
     sym += (uint32_t)((code - base[l]) >> (64 - l));
-    if (litIdx < (int)symLen[sym] + 1) break;
-    litIdx -= (int)symLen[sym] + 1;
+    if (e) {
+      if (e->numSyms == TB_BLOCK_CACHE_SYMS) return TB_MAX_SYMS;
+      e->sym[e->numSyms] = (uint16_t)sym;
+      e->start[e->numSyms++] = (uint16_t)pos;
+      pos += symLen[sym] + 1;
+      if (pos >= total) return 0;
+    } else {
+      if (*litIdx < (int)symLen[sym] + 1) break;
+      *litIdx -= (int)symLen[sym] + 1;
+    }
     code <<= l;
     bitCnt += l;
     if (bitCnt >= 32) {
@@ -1452,8 +1712,16 @@ static uint8_t *decompress_pairs(struct PairsData *d, size_t idx)
     int l = m;
     while (code < base[l]) l++;
     sym = offset[l] + ((code - base[l]) >> (32 - l));
-    if (litIdx < (int)symLen[sym] + 1) break;
-    litIdx -= (int)symLen[sym] + 1;
+    if (e) {
+      if (e->numSyms == TB_BLOCK_CACHE_SYMS) return TB_MAX_SYMS;
+      e->sym[e->numSyms] = (uint16_t)sym;
+      e->start[e->numSyms++] = (uint16_t)pos;
+      pos += symLen[sym] + 1;
+      if (pos >= total) return 0;
+    } else {
+      if (*litIdx < (int)symLen[sym] + 1) break;
+      *litIdx -= (int)symLen[sym] + 1;
+    }
     code <<= l;
     if (bitCnt < l) {
       if (bitCnt) {
@@ -1469,6 +1737,96 @@ static uint8_t *decompress_pairs(struct PairsData *d, size_t idx)
     bitCnt -= l;
   }
 #endif
+  return sym;
+}
+
+// Look up the symbol containing literal *litIdx of the given block in this
+// thread's block cache, decoding and inserting the block on a miss. Returns
+// false if the cache is disabled or the block cannot be cached.
+static bool block_cache_find(struct PairsData *d, uint32_t block, int *litIdx,
+    uint32_t *sym)
+{
+  unsigned size = blockCacheSize.load(memory_order_relaxed);
+  if (!size)
+    return false;
+
+  struct BlockCache *bc = &blockCache;
+  (void) &blockCacheOwner;  // registers this thread's cache on first use
+  uint32_t generation = blockCacheGeneration.load(memory_order_relaxed);
+  if (bc->generation != generation) {
+    for (unsigned i = 0; i < TB_BLOCK_CACHE_MAX; i++)
+      bc->entry[i].d = NULL;
+    bc->generation = generation;
+  }
+
+  bc->probes.store(bc->probes.load(memory_order_relaxed) + 1,
+      memory_order_relaxed);
+
+  struct BlockCacheEntry *e = NULL, *lru = &bc->entry[0];
+  for (unsigned i = 0; i < size; i++) {
+    struct BlockCacheEntry *c = &bc->entry[i];
+    if (c->d == d && c->block == block) {
+      e = c;
+      break;
+    }
+    if (!c->d || (lru->d && c->stamp < lru->stamp))
+      lru = c;
+  }
+
+  if (e)
+    bc->hits.store(bc->hits.load(memory_order_relaxed) + 1,
+        memory_order_relaxed);
+  else {
+    e = lru;
+    e->d = NULL;
+    e->numSyms = 0;
+    if (decode_block(d, block, NULL, e))
+      return false;
+    e->d = d;
+    e->block = block;
+  }
+  e->stamp = ++bc->stamp;
+
+  // Binary search for the last symbol starting at or before the literal
+  uint32_t lo = 0, hi = e->numSyms - 1;
+  while (lo < hi) {
+    uint32_t mid = (lo + hi + 1) / 2;
+    if (e->start[mid] <= *litIdx)
+      lo = mid;
+    else
+      hi = mid - 1;
+  }
+  *sym = e->sym[lo];
+  *litIdx -= e->start[lo];
+  return true;
+}
+
+static uint8_t *decompress_pairs(struct PairsData *d, size_t idx)
+{
+  if (!d->idxBits)
+    return d->constValue;
+
+  uint32_t mainIdx = (uint32_t)(idx >> d->idxBits);
+  int litIdx = (idx & (((size_t)1 << d->idxBits) - 1)) - ((size_t)1 << (d->idxBits - 1));
+  uint32_t block;
+  memcpy(&block, d->indexTable + 6 * mainIdx, sizeof(block));
+  block = from_le_u32(block);
+
+  uint16_t idxOffset = *(uint16_t *)(d->indexTable + 6 * mainIdx + 4);
+  litIdx += from_le_u16(idxOffset);
+
+  if (litIdx < 0)
+    while (litIdx < 0)
+      litIdx += d->sizeTable[--block] + 1;
+  else
+    while (litIdx > d->sizeTable[block])
+      litIdx -= d->sizeTable[block++] + 1;
+
+  uint32_t sym;
+  if (!block_cache_find(d, block, &litIdx, &sym))
+    sym = decode_block(d, block, &litIdx, NULL);
+
+  uint8_t *symLen = d->symLen;
   uint8_t *symPat = d->symPat;
   while (symLen[sym] != 0) {
     uint8_t *w = symPat + (3 * sym);
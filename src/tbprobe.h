@@ -199,6 +199,43 @@ unsigned tb_probe_root(
     bool     turn,     unsigned *results);
 
 
+/*
+ * Preload the WDL tables of up to `maxPieces' men in a background thread.
+ *
+ * PARAMETERS:
+ * - maxPieces:
+ *   The largest tables to preload (smaller tables are loaded first).  A value
+ *   below 3 just stops any preloading in progress.
+ *
+ * NOTES:
+ * - The tables are mapped and their pages read into the page cache, so that
+ *   the first probes do not have to wait for the disk.
+ * - Preloading is stopped by tb_init() and tb_free().
+ */
+void tb_preload(int maxPieces);
+
+/*
+ * Configure the per-thread cache of decompressed blocks.
+ *
+ * PARAMETERS:
+ * - entries:
+ *   The number of blocks each thread keeps in its LRU list (at most
+ *   TB_BLOCK_CACHE_MAX).  Zero disables the cache.
+ *
+ * NOTES:
+ * - The cache is (lazily) flushed by every thread on the next probe.
+ */
+#define TB_BLOCK_CACHE_MAX          64
+
+void tb_set_block_cache_size(unsigned entries);
+
+/*
+ * Report the number of block lookups and the number of them that were served
+ * from the block cache, accumulated over all threads since the last call to
+ * tb_init() or tb_set_block_cache_size().
+ */
+void tb_block_cache_stats(uint64_t *probes, uint64_t *hits);
+
 typedef uint16_t PyrrhicMove;
 
 struct TbRootMove {
@@ -0,0 +1,332 @@
+/*
+  This file is part of Gargantua, a UCI chess engine with NNUE evaluation
+  derived from Chess0, and inspired by Code Monkey King's bbc-1.4.
+
+  Copyright (C) 2025 Claudio M. Camacho
+
+  Gargantua is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Gargantua is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cinttypes>
+
+#include "search.h"
+#include "trace.h"
+
+
+
+using namespace std;
+
+
+
+// TraceEvent_t is a trace event: a complete event ('X', with a duration) or
+// an instant event ('i'); timestamps are in nanoseconds since startup
+typedef struct
+{
+    const char *name;
+    uint64_t    ts;
+    uint64_t    dur;
+    uint32_t    tid;
+    char        phase;
+    int         nargs;
+    TraceArg_t  args[TraceMaxArgs];
+} TraceEvent_t;
+
+
+
+// TraceBuffer is a ring buffer of events with a single producer (the thread
+// owning it) and a single consumer (flush()). The producer only advances
+// head, and the consumer only advances tail, so no locks are needed.
+struct TraceBuffer
+{
+    atomic<bool>     owned{false};
+    atomic<uint64_t> head{0};
+    atomic<uint64_t> tail{0};
+    atomic<uint64_t> dropped{0};
+    TraceEvent_t     events[TraceBufferEvents];
+};
+
+static TraceBuffer buffers[TraceMaxThreads];
+
+
+
+// Every thread takes a free buffer the first time it records an event, and
+// gives it back when it exits; the events left are still flushed later.
+struct TraceBufferOwner
+{
+    TraceBuffer *buffer = nullptr;
+    uint32_t     tid    = 0;
+
+    ~TraceBufferOwner()
+    {
+        if (buffer)
+            buffer->owned.store(false, memory_order_release);
+    }
+};
+
+static thread_local TraceBufferOwner owner;
+static atomic<uint32_t> nextTid(1);
+
+
+
+// Trace file, and whether tracing is enabled
+static FILE        *traceFile  = nullptr;
+static bool         firstEvent = true;
+static atomic<bool> tracing(false);
+
+
+
+// Time of startup, for the timestamps of the events
+static const auto epoch = chrono::steady_clock::now();
+
+
+
+// threadBuffer
+//
+// Return the trace buffer of the current thread, taking a free one if the
+// thread doesn't have one yet. Return nullptr if all buffers are taken.
+static TraceBuffer *threadBuffer()
+{
+    if (owner.buffer)
+        return owner.buffer;
+
+    for (int i = 0; i < TraceMaxThreads; i++)
+    {
+        bool expected = false;
+
+        if (buffers[i].owned.compare_exchange_strong(expected, true, memory_order_acquire))
+        {
+            owner.buffer = &buffers[i];
+            owner.tid    = nextTid++;
+            break;
+        }
+    }
+
+    return owner.buffer;
+}
+
+
+
+// record
+//
+// Add an event to the current thread's buffer, or drop it if it is full.
+static void record(const char *name, char phase, uint64_t ts, uint64_t dur,
+                   initializer_list<TraceArg_t> args)
+{
+    TraceBuffer *buffer = threadBuffer();
+
+    if (buffer == nullptr)
+        return;
+
+
+    // drop the event if the buffer is full
+    uint64_t head = buffer->head.load(memory_order_relaxed);
+
+    if (head - buffer->tail.load(memory_order_acquire) >= TraceBufferEvents)
+    {
+        buffer->dropped.fetch_add(1, memory_order_relaxed);
+        return;
+    }
+
+
+    // fill in the event and publish it
+    TraceEvent_t &event = buffer->events[head % TraceBufferEvents];
+
+    event.name  = name;
+    event.ts    = ts;
+    event.dur   = dur;
+    event.tid   = owner.tid;
+    event.phase = phase;
+    event.nargs = 0;
+
+    for (const TraceArg_t &arg : args)
+        if (event.nargs < TraceMaxArgs)
+            event.args[event.nargs++] = arg;
+
+    buffer->head.store(head + 1, memory_order_release);
+}
+
+
+
+// writeEvent
+//
+// Write an event to the trace file, in JSON format.
+static void writeEvent(const TraceEvent_t &event)
+{
+    fprintf(traceFile, "%s{\"name\":\"%s\",\"cat\":\"search\",\"ph\":\"%c\",\"ts\":%.3f,",
+            firstEvent ? "" : ",\n", event.name, event.phase, event.ts / 1000.0);
+
+    if (event.phase == 'X')
+        fprintf(traceFile, "\"dur\":%.3f,", event.dur / 1000.0);
+    else
+        fprintf(traceFile, "\"s\":\"t\",");
+
+    fprintf(traceFile, "\"pid\":1,\"tid\":%" PRIu32 ",\"args\":{", event.tid);
+
+    for (int i = 0; i < event.nargs; i++)
+    {
+        const TraceArg_t &arg = event.args[i];
+
+        if (string(arg.name) == "move")
+            fprintf(traceFile, "%s\"move\":\"%s\"", i ? "," : "",
+                    prettyMove(int(arg.value)).c_str());
+        else
+            fprintf(traceFile, "%s\"%s\":%" PRId64, i ? "," : "", arg.name, arg.value);
+    }
+
+    fprintf(traceFile, "}}");
+
+    firstEvent = false;
+}
+
+
+
+// Trace::open
+//
+// Start tracing into the given file (overwriting it). An empty path or
+// "<empty>" disables tracing.
+void Trace::open(const string &path)
+{
+    Trace::close();
+
+    if (path.empty() || (path == "<empty>"))
+        return;
+
+
+    // open the trace file and start the JSON array of events
+    traceFile = fopen(path.c_str(), "w");
+
+    if (traceFile == nullptr)
+    {
+        cout << "Couldn't open trace file " << path << endl;
+        return;
+    }
+
+    fprintf(traceFile, "[\n");
+    firstEvent = true;
+
+
+    // discard any events left from previous traces
+    for (int i = 0; i < TraceMaxThreads; i++)
+    {
+        buffers[i].tail.store(buffers[i].head.load(memory_order_acquire), memory_order_release);
+        buffers[i].dropped = 0;
+    }
+
+    tracing = true;
+}
+
+
+
+// Trace::close
+//
+// Flush the events left, finish the trace file and stop tracing.
+void Trace::close()
+{
+    if (traceFile == nullptr)
+        return;
+
+    Trace::flush();
+
+    tracing = false;
+
+    fprintf(traceFile, "\n]\n");
+    fclose(traceFile);
+
+    traceFile = nullptr;
+}
+
+
+
+// Trace::flush
+//
+// Write the events recorded by all threads to the trace file. This should
+// be called after the search, when the timing of the threads doesn't matter.
+void Trace::flush()
+{
+    if (traceFile == nullptr)
+        return;
+
+    uint64_t dropped = 0;
+
+    for (int i = 0; i < TraceMaxThreads; i++)
+    {
+        TraceBuffer &buffer = buffers[i];
+
+        uint64_t head = buffer.head.load(memory_order_acquire);
+        uint64_t tail = buffer.tail.load(memory_order_relaxed);
+
+        for ( ; tail < head; tail++)
+            writeEvent(buffer.events[tail % TraceBufferEvents]);
+
+        buffer.tail.store(head, memory_order_release);
+
+        dropped += buffer.dropped.exchange(0, memory_order_relaxed);
+    }
+
+    if (dropped)
+        cout << "info string trace buffers full, " << dropped << " events dropped" << endl;
+
+    fflush(traceFile);
+}
+
+
+
+// Trace::enabled
+//
+// Return true if events are being traced.
+bool Trace::enabled()
+{
+    return tracing.load(memory_order_relaxed);
+}
+
+
+
+// Trace::now
+//
+// Return the current time in nanoseconds since startup, to be used as the
+// start time of a complete event.
+uint64_t Trace::now()
+{
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - epoch).count();
+}
+
+
+
+// Trace::complete
+//
+// Record a complete event, from the given start time until now.
+void Trace::complete(const char *name, uint64_t start, initializer_list<TraceArg_t> args)
+{
+    if (!Trace::enabled())
+        return;
+
+    record(name, 'X', start, Trace::now() - start, args);
+}
+
+
+
+// Trace::instant
+//
+// Record an instant event, at the current time.
+void Trace::instant(const char *name, initializer_list<TraceArg_t> args)
+{
+    if (!Trace::enabled())
+        return;
+
+    record(name, 'i', Trace::now(), 0, args);
+}
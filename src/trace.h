@@ -0,0 +1,74 @@
+/*
+  This file is part of Gargantua, a UCI chess engine with NNUE evaluation
+  derived from Chess0, and inspired by Code Monkey King's bbc-1.4.
+
+  Copyright (C) 2025 Claudio M. Camacho
+
+  Gargantua is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Gargantua is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <string>
+#include <cstdint>
+#include <initializer_list>
+
+
+
+// Size of the trace buffers: no. of threads that can record events, no. of
+// events each thread can buffer between flushes (newer events are dropped
+// when the buffer is full), and no. of arguments per event
+#define TraceMaxThreads     16
+#define TraceBufferEvents 1024
+#define TraceMaxArgs         3
+
+
+
+// Argument of a trace event: a name (a string literal) and an integer value.
+// The value of an argument named "move" is printed as a move (e.g., e2e4).
+typedef struct
+{
+    const char *name;
+    int64_t     value;
+} TraceArg_t;
+
+
+
+// Search timeline tracing:
+//
+// When a trace file is set (TraceFile option), the search records events
+// (iterations, aspiration re-searches, info and bestmove output, stop
+// signals, hash table clears, etc.) in the Chrome trace-event JSON format,
+// which can be loaded in chrome://tracing or https://ui.perfetto.dev.
+//
+// Each thread records its events in its own lock-free buffer, without any
+// I/O; the buffers are only written to the file by flush(), after the
+// search, so that tracing doesn't change the timing being traced.
+namespace Trace
+{
+
+void open(const std::string &);
+void close();
+void flush();
+bool enabled();
+uint64_t now();
+void complete(const char *, uint64_t, std::initializer_list<TraceArg_t> = {});
+void instant(const char *, std::initializer_list<TraceArg_t> = {});
+
+}  //  namespace Trace
+
+
+
+#endif  //  TRACE_H
@@ -19,11 +19,14 @@
 */
 
 #include <iostream>
+#include <cstdlib>
 
 #include "bitboard.h"
 #include "tt.h"
 #include "position.h"
 #include "search.h"
+#include "stats.h"
+#include "trace.h"
 
 
 
@@ -31,14 +34,6 @@ using namespace std;
 
 
 
-// Zobrist hash keys for a given chess position:
-Bitboard piece_keys[12][64];
-Bitboard enpassant_keys[64];
-Bitboard castle_keys[16];
-Bitboard side_key;
-
-
-
 // Transposition Table data structure and initializations
 
 // current no. of total hash table entries
@@ -47,6 +42,9 @@ uint64_t hash_total_entries = 0ULL;
 // no. of hash entries used
 uint64_t hash_used = 0ULL;
 
+// age of the current search
+uint8_t hash_age = 0;
+
 
 
 // Global TT data structure
@@ -54,39 +52,85 @@ TTEntry_t *hash_table = nullptr;
 
 
 
-// initRandomKeys
+// Perft table data structure and usage statistics
+PerftEntry_t *perft_table = nullptr;
+uint64_t perft_total_entries = 0ULL;
+atomic<uint64_t> perft_probes(0);
+atomic<uint64_t> perft_hits(0);
+thread_local uint64_t perft_thread_probes = 0ULL;
+thread_local uint64_t perft_thread_hits   = 0ULL;
+
+
+
+// ZobristKeys_t holds all the Zobrist keys, in the order they are drawn from
+// the pseudo-random number generator.
+typedef struct
+{
+    std::array<std::array<Bitboard, 64>, 12> piece;
+    std::array<Bitboard, 64> enpassant;
+    std::array<Bitboard, 16> castle;
+    Bitboard side;
+    std::array<std::array<Bitboard, 16>, 12> material;
+} ZobristKeys_t;
+
+
+
+// genZobristKeys
 //
-// Define and initialize a few 64-bit arrays that will serve the
-// purpose of either building from scratch or incrementally updating
-// a unique chess board position identifier, aka the hash key.
-void initRandomKeys()
+// Generate the 64-bit keys that serve the purpose of either building from
+// scratch or incrementally updating a unique chess board position identifier,
+// aka the hash key. The keys are generated at compile time, always from the
+// same seed.
+static consteval ZobristKeys_t genZobristKeys()
 {
-    // update pseudo random number state
-    rng32_state = 1804289383;
+    ZobristKeys_t keys{};
+
+    // pseudo random number state
+    uint64_t state = 1070372ULL;
 
 
     // init random piece keys
     for (int piece = P; piece <= k; piece++)
         for (int square = 0; square < 64; square++)
-            piece_keys[piece][square] = rng64();
+            keys.piece[piece][square] = rng64(state);
 
     
     // init random enpassant keys
     for (int square = 0; square < 64; square++)
-        enpassant_keys[square] = rng64();
+        keys.enpassant[square] = rng64(state);
 
     
     // init castling keys
     for (int index = 0; index < 16; index++)
-        castle_keys[index] = rng64();
+        keys.castle[index] = rng64(state);
 
         
     // init random side key
-    side_key = rng64();
+    keys.side = rng64(state);
+
+
+    // init random material keys
+    for (int piece = P; piece <= k; piece++)
+        for (int count = 0; count < 16; count++)
+            keys.material[piece][count] = rng64(state);
+
+
+    return keys;
 }
 
 
 
+// Zobrist hash keys for a given chess position (@see tt.h)
+static constexpr ZobristKeys_t Zobrist = genZobristKeys();
+
+constexpr std::array<std::array<Bitboard, 64>, 12> piece_keys = Zobrist.piece;
+constexpr std::array<Bitboard, 64> enpassant_keys = Zobrist.enpassant;
+constexpr std::array<Bitboard, 16> castle_keys = Zobrist.castle;
+constexpr Bitboard side_key = Zobrist.side;
+constexpr std::array<std::array<Bitboard, 16>, 12> material_keys = Zobrist.material;
+
+
+
 // generateHashkey
 //
 // Generate "almost" unique hash keys for every given position.
@@ -133,6 +177,24 @@ uint64_t generateHashkey()
 
 
 
+// generateMaterialKey
+//
+// Generate the material key of the position from the piece counts: the key
+// of every piece of every type on the board, i.e., for each type of piece,
+// the keys of counts 0, 1, ... up to the no. of pieces (excluded).
+uint64_t generateMaterialKey()
+{
+    uint64_t final_key = 0ULL;
+
+    for (int piece = P; piece <= k; piece++)
+        for (int count = 0; count < pieceCount[piece]; count++)
+            final_key ^= material_keys[piece][count];
+
+    return final_key;
+}
+
+
+
 // TT::clear
 //
 // Clear the hash table containing the transposition table entries (TTEntry_t).
@@ -140,6 +202,9 @@ uint64_t generateHashkey()
 // again.
 void TT::clear()
 {
+    uint64_t traceStart = Trace::now();
+
+
     // init hash table entry pointer
     TTEntry_t *hash_entry;
 
@@ -151,6 +216,7 @@ void TT::clear()
         hash_entry->key         = 0ULL;
         hash_entry->depth       = 0;
         hash_entry->type        = 0;
+        hash_entry->age         = 0;
         hash_entry->value       = 0;
         hash_entry->best_move   = 0;
     }
@@ -158,6 +224,19 @@ void TT::clear()
 
     // reset the hash usage counter
     hash_used = 0ULL;
+
+    Trace::complete("tt clear", traceStart, {{"entries", int64_t(hash_total_entries)}});
+}
+
+
+
+// TT::newSearch
+//
+// Start a new search, with a new age for the entries it stores. Entries of
+// older searches can then be told apart, and replaced first.
+void TT::newSearch()
+{
+    hash_age = (hash_age + 1) & hash_age_mask;
 }
 
 
@@ -167,6 +246,9 @@ void TT::clear()
 // Dynamically allocate memory for the hash table (in MBytes).
 void TT::init(uint32_t mb)
 {
+    uint64_t traceStart = Trace::now();
+
+
     // init hash size
     int hash_size = mb * 1024 * 1024;
 
@@ -180,8 +262,9 @@ void TT::init(uint32_t mb)
         free(hash_table);
 
      
-    // allocate memory
-    hash_table = (TTEntry_t *) malloc(hash_total_entries * sizeof(TTEntry_t));
+    // allocate memory, with all the entries cleared: calloc() gets zeroed
+    // pages from the OS, so that they are only touched when first used
+    hash_table = (TTEntry_t *) calloc(hash_total_entries, sizeof(TTEntry_t));
 
 
     // if allocation has failed
@@ -189,15 +272,17 @@ void TT::init(uint32_t mb)
         cout << "Couldn't allocate memory for hash table!" << endl;
 
 
-    // if allocation succeeded, reset/clear the hash table entries
+    // if allocation succeeded, reset the hash usage counter
     else
     {
-        TT::clear();
+        hash_used = 0ULL;
 
         cout << "Hash table initialized with " << hash_total_entries << " entries (";
         cout << mb << " MBytes)";
         cout << endl;
     }
+
+    Trace::complete("tt resize", traceStart, {{"mb", mb}});
 }
 
 
@@ -209,15 +294,29 @@ void TT::init(uint32_t mb)
 // If the associated score is a beta-cutoff, return beta. 
 //
 // In case the given position is not found, return no_hash_found.
-int TT::probe(int alpha, int beta, int &best_move, int depth)
+//
+// Probes from the quiescence search (QSearch) are counted apart in the
+// search statistics.
+template <bool QSearch>
+int TT::probe(int alpha, int beta, Move &best_move, int depth)
 {
     // create a TT instance pointer to the hash entry in particular
     TTEntry_t *hash_entry = &hash_table[hash_key % hash_total_entries];
 
+    if constexpr (QSearch)
+        STAT(qsTTProbes);
+    else
+        STAT(ttProbes);
+
     
     // make sure we're dealing with the exact position we're looking for
     if (hash_entry->key == hash_key)
     {
+        if constexpr (QSearch)
+            STAT(qsTTHits);
+        else
+            STAT(ttHits);
+
         // check that the depth for the entry stored is the same or higher
         // (i.e., more accurate score)
         if (hash_entry->depth >= depth)
@@ -258,18 +357,30 @@ int TT::probe(int alpha, int beta, int &best_move, int depth)
     return no_hash_found;
 }
 
+template int TT::probe<false>(int, int, Move &, int);
+template int TT::probe<true>(int, int, Move &, int);
+
 
 
 // TT::save
 //
 // Populate the TTEntry with a new node's data, possibly overwriting an
 // old position. Update is not atomic and can end up in race conditions.
-void TT::save(int score, int best_move, int depth, int hash_type)
+//
+// The results of the quiescence search (depth 0) are the most frequent, and
+// the least valuable: they never overwrite the result of a deeper search of
+// the current search, but they do replace the ones left by older searches.
+void TT::save(int score, Move best_move, int depth, int hash_type)
 {
     // create a TT instance pointer to the hash entry in particular
     TTEntry_t *hash_entry = &hash_table[hash_key % hash_total_entries];
 
 
+    // keep the results of the full-width search
+    if ((depth == 0) && (hash_entry->depth > 0) && (hash_entry->age == hash_age))
+        return;
+
+
     // store the score independent from the actual path from root node
     if (score < -MateScore)
         score -= ply;
@@ -278,7 +389,7 @@ void TT::save(int score, int best_move, int depth, int hash_type)
 
 
     // if no collision, increment the counter of hash used
-    if (hash_entry->depth == 0)
+    if (hash_entry->key == 0ULL)
         hash_used++;
 
 
@@ -286,6 +397,62 @@ void TT::save(int score, int best_move, int depth, int hash_type)
     hash_entry->key       = hash_key;
     hash_entry->value     = score;
     hash_entry->type      = hash_type;
-    hash_entry->depth     = depth;
+    hash_entry->depth     = uint8_t(min(depth, 255));
     hash_entry->best_move = best_move;
+    hash_entry->age       = hash_age;
+}
+
+
+
+// PerftTT::init
+//
+// Dynamically allocate memory for the perft table (in MBytes), with all the
+// entries empty, and reset its usage statistics.
+void PerftTT::init(uint32_t mb)
+{
+    // free the previous table, if any
+    PerftTT::free();
+
+
+    // allocate memory and reset all entries
+    uint64_t entries = (uint64_t(mb) * 1024 * 1024) / sizeof(PerftEntry_t);
+    perft_table = (PerftEntry_t *) calloc(entries, sizeof(PerftEntry_t));
+
+    if (perft_table == nullptr)
+        cout << "Couldn't allocate memory for perft table!" << endl;
+    else
+        perft_total_entries = entries;
+
+
+    // reset the statistics
+    perft_probes = 0;
+    perft_hits   = 0;
+}
+
+
+
+// PerftTT::collectStats
+//
+// Add the probes and hits counted by the calling thread to the totals of the
+// perft table, and reset the thread's counters.
+void PerftTT::collectStats()
+{
+    perft_probes.fetch_add(perft_thread_probes, memory_order_relaxed);
+    perft_hits.fetch_add(perft_thread_hits, memory_order_relaxed);
+
+    perft_thread_probes = 0ULL;
+    perft_thread_hits   = 0ULL;
+}
+
+
+
+// PerftTT::free
+//
+// Release the memory of the perft table.
+void PerftTT::free()
+{
+    std::free(perft_table);
+
+    perft_table = nullptr;
+    perft_total_entries = 0ULL;
 }
@@ -21,6 +21,10 @@
 #ifndef TT_H
 #define TT_H
 
+#include <atomic>
+
+#include "bitboard.h"
+#include "position.h"
 
 
 // Zobrist hash keys for a given chess position. Every position includes:
@@ -28,10 +32,18 @@
 // - enpassant square
 // - castling rights
 // - side to move
-extern Bitboard piece_keys[12][64];
-extern Bitboard enpassant_keys[64];
-extern Bitboard castle_keys[16];
-extern Bitboard side_key;
+//
+// The keys are generated at compile time (@see tt.cpp).
+extern const std::array<std::array<Bitboard, 64>, 12> piece_keys;
+extern const std::array<Bitboard, 64> enpassant_keys;
+extern const std::array<Bitboard, 16> castle_keys;
+extern const Bitboard side_key;
+
+
+
+// Zobrist keys for the material key: one per piece type and count of pieces
+// of that type on the board
+extern const std::array<std::array<Bitboard, 16>, 12> material_keys;
 
 
 
@@ -39,9 +51,9 @@ extern Bitboard side_key;
 //
 // We use a C-stye array due to a much faster speed in read and
 // write performance. The array contains TTEntry objects, which
-// take 144 bits of space each (18 bytes).
+// take 128 bits of space each (16 bytes).
 //
-// That means a cache size of 1024MB will contain about ~60M entries.
+// That means a cache size of 1024MB will contain about ~67M entries.
 
 // no. of total hash table entries
 extern uint64_t hash_total_entries;
@@ -49,6 +61,9 @@ extern uint64_t hash_total_entries;
 // no. of hash entries used
 extern uint64_t hash_used;
 
+// age (generation) of the current search, stored in the entries it writes
+extern uint8_t hash_age;
+
 // Constant returned when no hash entry is found in TT
 #define no_hash_found 100000
 
@@ -59,31 +74,36 @@ extern uint64_t hash_used;
 
 
 
-// TTEntry struct is the 8 bytes transposition table entry, defined as below:
+// TTEntry struct is the 16 bytes transposition table entry, defined as below:
 //
 // key        64 bits
-// depth      32 bits
-// type       32 bits
 // value      32 bits
-// best_move  32 bits
+// best_move  16 bits
+// depth       8 bits (deeper entries are stored as 255)
+// type        2 bits
+// age         6 bits (search that wrote the entry, @see TT::newSearch())
 //
-// Total size (per entry): 192 bits / 24 bytes
+// Total size (per entry): 128 bits / 16 bytes
 typedef struct {
-    uint64_t key;   
-    int      depth;      
-    int      type;       
-    int      value;
-    int      best_move;
+    uint64_t key;
+    int32_t  value;
+    Move     best_move;
+    uint8_t  depth;
+    uint8_t  type : 2;
+    uint8_t  age  : 6;
 } TTEntry_t;
 
+// ages wrap around after 64 searches
+#define hash_age_mask 63
+
 // Global Transposition Table data structure:
 extern TTEntry_t *hash_table;
 
 
 
 // Zobrist hash key functionality:
-void initRandomKeys();
 uint64_t generateHashkey();
+uint64_t generateMaterialKey();
 
 
 
@@ -94,8 +114,9 @@ namespace TT
 
 void clear();
 void init(uint32_t);
-int probe(int, int, int &, int);
-void save(int, int, int, int);
+void newSearch();
+template <bool QSearch = false> int probe(int, int, Move &, int);
+void save(int, Move, int, int);
 
 
 
@@ -118,4 +139,84 @@ static inline int hashfull()
 
 
 
+// Perft hash table:
+//
+// A separate table used only by perft(), that maps a position and a depth to
+// the number of leaf nodes below it. Every entry is made of two 64-bit words,
+// the data (leaf count << 8 | depth) and the hash key XOR'ed with the data.
+// Both words are read and written without locks; a torn entry (two threads
+// writing the same slot at once) is detected because its key no longer
+// matches, so a probe can never return the count of a different position.
+
+// PerftEntry_t is the 16 bytes perft table entry
+typedef struct {
+    uint64_t check;
+    uint64_t data;
+} PerftEntry_t;
+
+// Global perft table data structure and its no. of entries
+extern PerftEntry_t *perft_table;
+extern uint64_t perft_total_entries;
+
+// perft table usage statistics: every thread counts its own probes and hits,
+// and adds them to the totals when it is done (@see PerftTT::collectStats())
+extern std::atomic<uint64_t> perft_probes;
+extern std::atomic<uint64_t> perft_hits;
+extern thread_local uint64_t perft_thread_probes;
+extern thread_local uint64_t perft_thread_hits;
+
+
+
+namespace PerftTT
+{
+
+void init(uint32_t);
+void free();
+void collectStats();
+
+
+
+// PerftTT::probe
+//
+// Look up the leaf count of the current position at the given depth. Return
+// true and the count in 'leaves' if it is found.
+static inline bool probe(int depth, uint64_t &leaves)
+{
+    PerftEntry_t *entry = &perft_table[hash_key % perft_total_entries];
+
+    uint64_t check = std::atomic_ref<uint64_t>(entry->check).load(std::memory_order_relaxed);
+    uint64_t data  = std::atomic_ref<uint64_t>(entry->data).load(std::memory_order_relaxed);
+
+    perft_thread_probes++;
+
+    if (((check ^ data) != hash_key) || (int(data & 0xff) != depth))
+        return false;
+
+    perft_thread_hits++;
+    leaves = data >> 8;
+
+    return true;
+}
+
+
+
+// PerftTT::save
+//
+// Store the leaf count of the current position at the given depth, always
+// replacing the previous entry.
+static inline void save(int depth, uint64_t leaves)
+{
+    PerftEntry_t *entry = &perft_table[hash_key % perft_total_entries];
+    uint64_t data = (leaves << 8) | uint64_t(depth);
+
+    std::atomic_ref<uint64_t>(entry->check).store(hash_key ^ data, std::memory_order_relaxed);
+    std::atomic_ref<uint64_t>(entry->data).store(data, std::memory_order_relaxed);
+}
+
+
+
+}  //  namespace PerftTT
+
+
+
 #endif  //  TT_H
@@ -23,6 +23,7 @@
 #include <string>
 #include <chrono>
 #include <future>
+#include <algorithm>
 
 #include "bitboard.h"
 #include "movgen.h"
@@ -31,6 +32,12 @@
 #include "uci.h"
 #include "eval.h"
 #include "tt.h"
+#include "tb.h"
+#include "tbprobe.h"
+#include "book.h"
+#include "bench.h"
+#include "stats.h"
+#include "trace.h"
 
 
 
@@ -49,7 +56,7 @@ using namespace std;
 // The only special case is castling, where we print in the e1g1 notation in
 // normal chess mode, and in e1h1 notation in chess960 mode. Internally all
 // castling moves are always encoded as 'king captures rook'.
-string UCI::moveToString(int m)
+string UCI::moveToString(Move m)
 {
     // get source and target square coordinates
     int fromSq = getMoveSource(m);
@@ -79,7 +86,7 @@ string UCI::moveToString(int m)
 // Note: the move will be considered legal if it is in the pseudo-legal moves
 //       list. That means you must take care of checking legality after parsing
 //       the move, before making it on the board; i.e, is King in check?
-int UCI::parseMove(string str)
+Move UCI::parseMove(string str)
 {
     // verify promotion and make sure it is in lower-case
     if (str.length() == 5)
@@ -94,8 +101,8 @@ int UCI::parseMove(string str)
     // try to find the move in the list of pseudo-legal moves
     for (int move_count = 0; move_count < MoveList.count; move_count++)
     {
-        if (str == moveToString(MoveList.moves[move_count]))
-            return MoveList.moves[move_count];
+        if (str == moveToString(MoveList.moves[move_count].move))
+            return MoveList.moves[move_count].move;
     }
 
 
@@ -186,9 +193,11 @@ void UCI::go(istringstream &is)
     string token;
 
 
-    // reset search configuration before making a new search
+    // reset search configuration before making a new search, and take the
+    // options for this search
     resetLimits();
     resetTimeControl();
+    UCI::snapshotOptions();
 
 
     // parse sub-commands
@@ -302,16 +311,62 @@ void UCI::go(istringstream &is)
         }
 
 
-        // run "perft" test
+        // run "perft" test: "go perft <depth> [hash <MB>] [verify]"
         else if (token == "perft")
         {
+            int  hash   = 0;
+            bool verify = false;
+
             is >> Limits.perft;
-            dperft(Limits.perft);
+
+            while (is >> token)
+            {
+                if (token == "hash")
+                    is >> hash;
+                else if (token == "verify")
+                    verify = true;
+            }
+
+            dperft(max(Limits.perft, 1), clamp(hash, 0, HashMaxSize), verify);
+            return;
+        }
+    }
+
+
+    // play instantly from the opening book, if the position is in it
+    if (SearchOptions.ownBook && !Limits.infinite)
+    {
+        Move move = Book::probe();
+
+        if (move)
+        {
+            cout << "bestmove " << UCI::moveToString(move) << endl << flush;
+            timedout = true;
             return;
         }
     }
 
 
+    // nodes as time (nodestime): the engine keeps its own clock, counted in
+    // nodes, and the time for this move is allotted from it (as ms, npmsec
+    // nodes each) instead of from the GUI's clock. This makes timed games
+    // reproducible and independent of the hardware
+    Limits.npmsec = SearchOptions.nodestime;
+
+    int  clock      = (sideToMove == White) ? Limits.wtime : Limits.btime;
+    bool nodesClock = Limits.npmsec && (clock > 0) && !Limits.infinite;
+
+    if (nodesClock)
+    {
+        // the clock starts with the first timed search of the game
+        if (availableNodes == 0)
+            availableNodes = int64_t(clock) * Limits.npmsec;
+
+        if (Limits.movetime == uint64_t(clock))
+            Limits.movetime = max(availableNodes / Limits.npmsec, int64_t(1));
+    }
+
+
     // configure internal timing, if time control is available
     if ((Limits.movetime > 0) && !Limits.infinite)
     {
@@ -332,12 +387,90 @@ void UCI::go(istringstream &is)
     }
 
 
+    // with nodestime, turn the time for this move into a budget of nodes,
+    // npmsec nodes per millisecond, and don't look at the clock
+    if (Limits.npmsec && timeset && (stoptime > starttime))
+    {
+        uint64_t budget = (stoptime - starttime) * Limits.npmsec;
+
+        Limits.nodes = Limits.nodes ? min(Limits.nodes, budget) : budget;
+        timeset      = false;
+    }
+
+
     // constaintly watch the clock and other limits that will stop the search
     auto io = async(launch::async, watchClockAndInput);
 
 
     // start the search
     search();
+
+
+    // charge the nodes searched to the engine's clock, and add the increment
+    if (nodesClock)
+        availableNodes = max(availableNodes - int64_t(nodes) + int64_t(inc) * Limits.npmsec,
+                             int64_t(1));
+}
+
+
+
+// Table of all the UCI options, in the order they are listed to the GUI:
+//
+//  name, type, default, min, max, default text, function called on change
+static Option_t OptionsTable[] =
+{
+    { "Hash", OptionSpin, OptionsDefaultHashSize, HashMinSize, HashMaxSize, "",
+      [](const Option_t &o) { TT::init(o.value); } },
+
+    { "Clear Hash", OptionButton, 0, 0, 0, "",
+      [](const Option_t &) { TT::clear(); } },
+
+    { "Contempt", OptionSpin, OptionsDefaultContempt, OptionsContemptMin, OptionsContemptMax, "",
+      nullptr },
+
+    { "nodestime", OptionSpin, 0, 0, OptionsNodestimeMax, "",
+      nullptr },
+
+    { "OwnBook", OptionCheck, false, 0, 0, "",
+      nullptr },
+
+    { "BookFile", OptionString, 0, 0, 0, "<empty>",
+      [](const Option_t &o) { Book::init(o.text); } },
+
+    { "SyzygyPath", OptionString, 0, 0, 0, "<empty>",
+      [](const Option_t &o) { TB::init(o.text); } },
+
+    { "SyzygyCache", OptionSpin, SyzygyCacheDefault, SyzygyCacheMin, SyzygyCacheMax, "",
+      [](const Option_t &o) { TB::initCache(o.value); } },
+
+    { "SyzygyBlockCache", OptionSpin, SyzygyBlockCacheDefault, SyzygyBlockCacheMin, SyzygyBlockCacheMax, "",
+      [](const Option_t &o) { tb_set_block_cache_size(o.value); } },
+
+    { "SyzygyPreload", OptionCheck, false, 0, 0, "",
+      [](const Option_t &o) { TB::setPreload(o.value); } },
+
+    { "TraceFile", OptionString, 0, 0, 0, "<empty>",
+      [](const Option_t &o) { Trace::open(o.text); } },
+};
+
+
+
+// findOption
+//
+// Return the option with the given name (case insensitive, as per the UCI
+// protocol), or nullptr if there is no such option.
+static Option_t *findOption(const string &name)
+{
+    for (Option_t &option : OptionsTable)
+    {
+        string optionName = option.name;
+
+        if (equal(name.begin(), name.end(), optionName.begin(), optionName.end(),
+                  [](char a, char b) { return tolower(a) == tolower(b); }))
+            return &option;
+    }
+
+    return nullptr;
 }
 
 
@@ -345,7 +478,8 @@ void UCI::go(istringstream &is)
 // UCI::setOption
 //
 // UCI::setOption() is called when engine receives the "setoption" UCI command.
-// The function updates the UCI option ("name") to the given value ("value").
+// The function updates the UCI option ("name") to the given value ("value"),
+// within its bounds, and calls the option's function to apply the change.
 void UCI::setOption(istringstream& is)
 {
     // variables to parse the options
@@ -366,54 +500,89 @@ void UCI::setOption(istringstream& is)
         value += (value.empty() ? "" : " ") + token;
 
 
-    // option name Hash type spin default 1024 min 16 max 1024
-    if (name == "Hash")
-    {
-        // obtain the MBytes from the value given in the option
-        int mb = stoi(value);
+    // find the option
+    Option_t *option = findOption(name);
 
-        // check min and max size boundaries
-        if (mb < HashMinSize)
-            mb = HashMinSize;
+    if (option == nullptr)
+    {
+        cout << "No such option: " << name << endl << flush;
+        return;
+    }
 
-        if(mb > HashMaxSize)
-            mb = HashMaxSize;
 
+    // update the option's value, depending on its type
+    switch (option->type)
+    {
+        case OptionSpin:
+            option->value = clamp(atoi(value.c_str()), option->min, option->max);
+            break;
 
-        // register the new setting in Options
-        Options["Hash"] = mb;
+        case OptionCheck:
+            option->value = (value == "true");
+            break;
 
+        // an empty value resets the string (e.g., disables a file)
+        case OptionString:
+            option->text = value.empty() ? "<empty>" : value;
+            break;
 
-        // set hash table size in MB
-        TT::init(mb);
+        case OptionButton:
+            break;
     }
 
 
-    // option name Clear Hash type button
-    else if (name == "Clear Hash")
-        TT::clear();
+    // apply the change
+    if (option->onChange)
+        option->onChange(*option);
+}
+
 
 
-    // option name Contempt type spin 
-    else if (name == "Contempt")
+// UCI::printOptions
+//
+// Print the list of options supported by the engine, in reply to 'uci'.
+void UCI::printOptions()
+{
+    for (const Option_t &option : OptionsTable)
     {
-        // obtain the new contempt factor from the given option
-        int new_contempt = stoi(value);
+        cout << "option name " << option.name;
 
+        switch (option.type)
+        {
+            case OptionSpin:
+                cout << " type spin default " << option.defaultValue
+                     << " min " << option.min << " max " << option.max;
+                break;
+
+            case OptionCheck:
+                cout << " type check default " << (option.defaultValue ? "true" : "false");
+                break;
+
+            case OptionString:
+                cout << " type string default " << option.defaultText;
+                break;
+
+            case OptionButton:
+                cout << " type button";
+                break;
+        }
 
-        // set the contempt factor to the given setting
-        if (new_contempt < OptionsContemptMin)
-            Options["Contempt"] = OptionsContemptMin;
-        else if (new_contempt > OptionsContemptMax)
-            Options["Contempt"] = OptionsContemptMax;
-        else
-            Options["Contempt"] = new_contempt;
+        cout << endl;
     }
+}
 
 
-    // unknown option
-    else
-        cout << "No such option: " << name << endl << flush;
+
+// UCI::snapshotOptions
+//
+// Copy the current value of the options used by the search into
+// SearchOptions. This is done before every search, so that the search only
+// reads plain variables.
+void UCI::snapshotOptions()
+{
+    SearchOptions.contempt  = findOption("Contempt")->value;
+    SearchOptions.nodestime = findOption("nodestime")->value;
+    SearchOptions.ownBook   = findOption("OwnBook")->value;
 }
 
 
@@ -498,9 +667,7 @@ void UCI::loop(int argc, char* argv[])
             cout << "id name "   << EngineName << " " << EngineVersion << endl;
             cout << "id author " << EngineAuthor << endl; 
 
-            cout << "option name Hash type spin default 1024 min 16 max 1024" << endl;
-            cout << "option name Clear Hash type button" << endl;
-            cout << "option name Contempt type spin default 25 min 0 max 200" << endl;
+            UCI::printOptions();
 
             cout << "uciok" << endl << flush;
         }
@@ -527,6 +694,9 @@ void UCI::loop(int argc, char* argv[])
             setPosition(FenPosStartpos);
             TT::clear();
             initSearch();
+
+            // the nodestime clock starts again with the new game
+            availableNodes = 0;
         }
 
 
@@ -551,6 +721,18 @@ void UCI::loop(int argc, char* argv[])
             printHelp();
 
 
+        // "makebook": compile a text file of analysed positions into a book
+        else if (token == "makebook")
+        {
+            string input, output;
+
+            if (is >> input >> output)
+                Book::build(input, output);
+            else
+                cout << "Usage: makebook <input.txt> <output.bin>" << endl;
+        }
+
+
         // "moves": print the list of pseudo-legal moves, non-sorted
         else if (token == "moves")
         {
@@ -570,7 +752,34 @@ void UCI::loop(int argc, char* argv[])
         }
 
 
-        //else if (token == "bench")    bench(pos, is, states);
+        // "bench": search a fixed suite of positions and report the nodes
+        else if (token == "bench")
+        {
+            int  hash    = BenchDefaultHash;
+            int  threads = BenchDefaultThreads;
+            int  depth   = BenchDefaultDepth;
+            bool perf    = false;
+
+            // numeric arguments are positional; "perf" can go anywhere
+            int *args[] = { &hash, &threads, &depth };
+            int  nargs  = 0;
+
+            while (is >> token)
+            {
+                if (token == "perf")
+                    perf = true;
+                else if (nargs < 3)
+                    *args[nargs++] = atoi(token.c_str());
+            }
+
+            UCI::snapshotOptions();
+            bench(clamp(hash, HashMinSize, HashMaxSize), max(threads, 1),
+                  clamp(depth, 1, MaxSearchDepth), perf);
+
+            // restore the hash table size, unless running from command line
+            if (argc == 1)
+                TT::init(findOption("Hash")->value);
+        }
 
 
         // "d": show the current board
@@ -586,6 +795,16 @@ void UCI::loop(int argc, char* argv[])
             traceEval();
 
 
+        // "stats": print the statistics of the last search
+        else if (token == "stats")
+            Stats::print();
+
+
+        // "tbstats": print the tablebases' cache usage
+        else if (token == "tbstats")
+            TB::printStats();
+
+
         // "unknown command"
         else if (!token.empty() && token[0] != '#')
             cout << "Unknown command: " << cmd << endl << flush;
@@ -603,6 +822,9 @@ void UCI::printHelp()
     cout << endl << endl;
     cout << "Help:" << endl;
 
+    cout << "- bench [hash] [threads] [depth] [perf]: search a fixed suite of positions";
+    cout << endl;
+
     cout << "- d: display the current position on the board";
     cout << endl;
 
@@ -612,10 +834,22 @@ void UCI::printHelp()
     cout << "- flip: flip the board when being printed";
     cout << endl;
 
+    cout << "- go perft <depth> [hash <MB>] [verify]: count the leaf nodes per move";
+    cout << endl;
+
+    cout << "- makebook <input> <output>: compile analysed positions into a book";
+    cout << endl;
+
     cout << "- moves: print the list of pseudo-legal moves, without being sorted";
     cout << endl;
 
     cout << "- smoves: print the list of pseudo-legal moves, sorted by score";
+    cout << endl;
+
+    cout << "- stats: print the statistics of the last search, per depth";
+    cout << endl;
+
+    cout << "- tbstats: print the hit rates of the tablebases' caches";
     cout << endl << endl;
 }
 
@@ -626,6 +860,11 @@ void UCI::printHelp()
 // Set the engine options to the original defaults.
 void UCI::resetOptions()
 {
-    Options["Hash"]     = OptionsDefaultHashSize;
-    Options["Contempt"] = OptionsDefaultContempt;
+    for (Option_t &option : OptionsTable)
+    {
+        option.value = option.defaultValue;
+        option.text  = option.defaultText;
+    }
+
+    UCI::snapshotOptions();
 }
@@ -21,7 +21,7 @@
 #ifndef UCI_H
 #define UCI_H
 
-#include <map>
+#include <string>
 
 
 
@@ -39,19 +39,46 @@
 
 
 
+// Types of UCI options
+enum OptionType { OptionSpin, OptionCheck, OptionString, OptionButton };
+
+
+
+// Option_t describes a UCI option: its name, type, default value and bounds
+// (for spin options) and the function called when the GUI changes it, along
+// with its current value (spin and check options) or text (string options).
+// All the options are registered in a single table in uci.cpp, which is used
+// to print the 'uci' option list and to dispatch 'setoption'.
+typedef struct Option_t
+{
+    const char  *name;
+    OptionType   type;
+    int          defaultValue;
+    int          min;
+    int          max;
+    const char  *defaultText;
+    void       (*onChange)(const struct Option_t &);
+    int          value;
+    std::string  text;
+} Option_t;
+
+
+
 // UCI interface functionality, including move parsing, UCI commands, etc.
 namespace UCI 
 {
 
-string moveToString(int m);
-int parseMove(string);
+string moveToString(Move m);
+Move parseMove(string);
 void position(istringstream &);
 void go(istringstream &);
 void setOption(istringstream &);
 void traceEval();
 void loop(int argc, char *argv[]);
 void printHelp();
+void printOptions();
 void resetOptions();
+void snapshotOptions();
 
 }  //  namespace UCI
 